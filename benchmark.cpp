@@ -0,0 +1,371 @@
+#include "dpll_solver.h"
+#include <map>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+// The configurations that the benchmark runs: every heuristic with and without pure literal elimination, and with --extended also watched literals, clause learning and lookahead. The names are the ones display_plot.py shows.
+const vector<pair<string, vector<string>>> basic_configs = {
+    {"none", {}},
+    {"purelit", {"-p"}},
+    {"SLIS", {"-slis"}},
+    {"SLIS + purelit", {"-slis", "-p"}},
+    {"SLCS", {"-slcs"}},
+    {"SLCS + purelit", {"-slcs", "-p"}},
+    {"DLIS", {"-dlis"}},
+    {"DLIS + purelit", {"-dlis", "-p"}},
+    {"DLCS", {"-dlcs"}},
+    {"DLCS + purelit", {"-dlcs", "-p"}},
+    {"backtrack count", {"-bc"}},
+    {"backtrack count + purelit", {"-bc", "-p"}},
+    {"MOM", {"-mom"}},
+    {"MOM + purelit", {"-mom", "-p"}},
+    {"Boehm", {"-boehm"}},
+    {"Boehm + purelit", {"-boehm", "-p"}},
+    {"Jeroslow-Wang", {"-jw"}},
+    {"Jeroslow-Wang + purelit", {"-jw", "-p"}},
+};
+const vector<pair<string, vector<string>>> extended_configs = {
+    {"watched", {"-wl"}},
+    {"SLIS + watched", {"-slis", "-wl"}},
+    {"SLCS + watched", {"-slcs", "-wl"}},
+    {"backtrack count + watched", {"-bc", "-wl"}},
+    {"CDCL", {"-cdcl"}},
+    {"backtrack count + CDCL", {"-bc", "-cdcl"}},
+    {"lookahead", {"-la"}},
+};
+
+// The outcome of one run of the solver on one file.
+struct Run {
+    string config;
+    string file;
+    string result;  // sat, unsat, timeout, wrong (a model that does not satisfy the formula) or error
+    double wall_time = 0;
+    double cpu_time = 0;  // user and system time of the solver process
+    long peak_rss = 0;  // in KiB
+    vector<pair<string, string>> counters;  // the "c name: value" lines of the solver's output, only printed by builds with -DDPLL_STATS
+};
+
+// Check the "v" line of a satisfiable answer against the formula.
+bool check_model(const string& file, const string& output) {
+    Formula formula;
+    if (!fromFile(file, formula)) { return false; }
+    vector<bool> is_true(formula.num_vars+1, false);
+    size_t v_line = output.find("\nv ");
+    if (v_line == string::npos) { return false; }
+    istringstream lits(output.substr(v_line+3));
+    int lit;
+    while (lits >> lit && lit != 0) {
+        if (lit > 0 && lit <= formula.num_vars) { is_true[lit] = true; }
+    }
+    ClauseArena& clauses = formula.clauses;
+    for (CRef cr = 0; cr < clauses.memory.size(); cr += ClauseArena::words(clauses[cr])) {
+        Clause& cl = clauses[cr];
+        if (none_of(cl.begin(), cl.end(), [&is_true](int lit) { return is_true[abs(lit)] == (lit > 0); })) { return false; }
+    }
+    return true;
+}
+
+// Run a program as a child process and collect its standard output. The process is killed when it exceeds the timeout, and false is returned. Its time and peak memory are taken from wait4. If the process cannot be started, the output stays empty, which counts as an error.
+bool run_process(vector<string> args, double timeout, string& output, rusage& usage) {
+    usage = rusage{};
+    int out_pipe[2];
+    // Other workers fork at the same time. Their children must not inherit this pipe, or it would only reach EOF when they exit as well.
+    if (pipe2(out_pipe, O_CLOEXEC) < 0) { return true; }
+    vector<char*> argv;
+    for (string& arg: args) { argv.push_back(&arg[0]); }
+    argv.push_back(nullptr);
+
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(out_pipe[1], STDOUT_FILENO);
+        ::close(out_pipe[0]);
+        ::close(out_pipe[1]);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    // Without a child, wait4(-1) could reap another worker's child and kill(-1) would signal every process of the user.
+    if (pid < 0) {
+        ::close(out_pipe[0]);
+        ::close(out_pipe[1]);
+        return true;
+    }
+    ::close(out_pipe[1]);
+    bool timed_out = false;
+    char buffer[1 << 16];
+    while (true) {
+        double remaining = timeout - chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (remaining <= 0) {
+            kill(pid, SIGKILL);
+            timed_out = true;
+            break;
+        }
+        pollfd fd{out_pipe[0], POLLIN, 0};
+        if (poll(&fd, 1, (int)ceil(remaining * 1000)) <= 0) { continue; }
+        ssize_t n = read(out_pipe[0], buffer, sizeof(buffer));
+        if (n <= 0) { break; }
+        output.append(buffer, n);
+    }
+    ::close(out_pipe[0]);
+    int status;
+    wait4(pid, &status, 0, &usage);
+    return !timed_out;
+}
+
+// Run the solver on one file. With a proof path, an unsatisfiable answer only counts if the proof checker prints "s VERIFIED" for it within the timeout.
+Run run_solver(const string& solver, const pair<string, vector<string>>& config, const string& file, double timeout, const string& seed, const string& checker, const string& proof_path) {
+    Run run;
+    run.config = config.first;
+    run.file = file;
+    vector<string> args{solver};
+    args.insert(args.end(), config.second.begin(), config.second.end());
+    if (!seed.empty()) { args.insert(args.end(), {"--seed", seed}); }
+    if (!proof_path.empty()) { args.insert(args.end(), {"--proof", proof_path}); }
+    args.push_back(file);
+
+    auto start = chrono::steady_clock::now();
+    string output;
+    rusage usage;
+    bool finished = run_process(args, timeout, output, usage);
+    run.wall_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    run.cpu_time = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    run.peak_rss = usage.ru_maxrss;
+
+    if (!finished) { run.result = "timeout"; }
+    else if (output.find("s UNSATISFIABLE") != string::npos) { run.result = "unsat"; }
+    else if (output.find("s SATISFIABLE") != string::npos) { run.result = check_model(file, output) ? "sat" : "wrong"; }
+    else { run.result = "error"; }
+
+    if (run.result == "unsat" && !proof_path.empty()) {
+        string checker_output;
+        rusage checker_usage;
+        run_process({checker, file, proof_path}, timeout, checker_output, checker_usage);
+        if (checker_output.find("s VERIFIED") == string::npos) { run.result = "wrong"; }
+    }
+    if (!proof_path.empty()) { filesystem::remove(proof_path); }
+
+    istringstream lines(output);
+    string line;
+    while (getline(lines, line)) {
+        size_t colon = line.find(": ");
+        if (line.compare(0, 2, "c ") != 0 || colon == string::npos || line.find(' ', colon+2) != string::npos) { continue; }
+        run.counters.push_back({line.substr(2, colon-2), line.substr(colon+2)});
+    }
+    return run;
+}
+
+// Combine the repetitions of a run into the one with the median CPU time, where a timeout counts as slower than any finished run. A wrong answer or an error in any repetition is kept, so that it is reported.
+Run median_run(vector<Run>& repetitions) {
+    for (Run& run: repetitions) {
+        if (run.result == "wrong" || run.result == "error") { return run; }
+    }
+    sort(repetitions.begin(), repetitions.end(), [](const Run& r1, const Run& r2) {
+        return make_pair(r1.result == "timeout", r1.cpu_time) < make_pair(r2.result == "timeout", r2.cpu_time);
+    });
+    return repetitions[repetitions.size() / 2];
+}
+
+// The penalized average runtime: the CPU time of a solved instance, twice the timeout for an unsolved one.
+double par2(const vector<const Run*>& runs, double timeout) {
+    double sum = 0;
+    for (const Run* run: runs) { sum += (run->result == "sat" || run->result == "unsat") ? run->cpu_time : 2*timeout; }
+    return runs.empty() ? 0 : sum / runs.size();
+}
+
+// Write one line per run. The counter columns are the union of the counters of all runs.
+void write_csv(const string& path, const vector<Run>& runs) {
+    vector<string> counter_names;
+    for (const Run& run: runs) {
+        for (auto& counter: run.counters) {
+            if (find(counter_names.begin(), counter_names.end(), counter.first) == counter_names.end()) { counter_names.push_back(counter.first); }
+        }
+    }
+    ofstream out(path);
+    out << "config,file,result,wall_time,cpu_time,peak_rss_kb";
+    for (string& name: counter_names) { out << "," << name; }
+    out << "\n";
+    for (const Run& run: runs) {
+        out << run.config << "," << run.file << "," << run.result << "," << run.wall_time << "," << run.cpu_time << "," << run.peak_rss;
+        for (string& name: counter_names) {
+            auto counter = find_if(run.counters.begin(), run.counters.end(), [&name](auto& c) { return c.first == name; });
+            out << "," << ((counter != run.counters.end()) ? counter->second : "");
+        }
+        out << "\n";
+    }
+}
+
+// Read the config, file, result and cpu_time columns of a results file written by an earlier benchmark.
+vector<Run> read_csv(const string& path) {
+    vector<Run> runs;
+    ifstream in(path);
+    string line;
+    getline(in, line);  // the header
+    while (getline(in, line)) {
+        vector<string> fields;
+        istringstream columns(line);
+        string field;
+        while (getline(columns, field, ',')) { fields.push_back(field); }
+        if (fields.size() < 6) { continue; }
+        Run run;
+        run.config = fields[0];
+        run.file = fields[1];
+        run.result = fields[2];
+        run.wall_time = stod(fields[3]);
+        run.cpu_time = stod(fields[4]);
+        run.peak_rss = stol(fields[5]);
+        runs.push_back(run);
+    }
+    return runs;
+}
+
+// Write the CPU times of the solved instances per configuration in the JSON format that display_plot.py reads.
+void write_plot_json(const string& path, const vector<pair<string, vector<string>>>& configs, const vector<Run>& runs) {
+    ofstream out(path);
+    out << "{";
+    for (size_t c = 0; c < configs.size(); ++c) {
+        out << ((c > 0) ? ", " : "") << "\"" << configs[c].first << "\": [";
+        const char* separator = "";
+        for (const Run& run: runs) {
+            if (run.config != configs[c].first || (run.result != "sat" && run.result != "unsat")) { continue; }
+            out << separator << run.cpu_time;
+            separator = ", ";
+        }
+        out << "]";
+    }
+    out << "}";
+}
+
+int main(int argc, const char* argv[]) {
+    vector<string> positional;
+    int jobs = max(1u, thread::hardware_concurrency());
+    string baseline_path;
+    string plot_path;
+    string seed;  // passed on to the solver, which uses its own default seed otherwise
+    string checker;  // the proof checker for the unsatisfiable answers, empty for none
+    double tolerance = 0.1;  // the relative increase of a PAR-2 score that counts as a regression
+    int repeat = 1;  // the number of times every configuration runs on every file
+    bool extended = false;
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (option == "--jobs" && i+1 < argc && atoi(argv[i+1]) > 0) { jobs = atoi(argv[++i]); }
+        else if (option == "--baseline" && i+1 < argc) { baseline_path = argv[++i]; }
+        else if (option == "--plot" && i+1 < argc) { plot_path = argv[++i]; }
+        else if (option == "--tolerance" && i+1 < argc) { tolerance = atof(argv[++i]); }
+        else if (option == "--seed" && i+1 < argc) { seed = argv[++i]; }
+        else if (option == "--check-proofs" && i+1 < argc) { checker = argv[++i]; }
+        else if (option == "--repeat" && i+1 < argc && atoi(argv[i+1]) > 0) { repeat = atoi(argv[++i]); }
+        else if (option == "--extended") { extended = true; }
+        else if (option[0] == '-') {
+            cout << "Unknown argument: " << option << "\n";
+            positional.clear();
+            break;
+        } else { positional.push_back(option); }
+    }
+    if (positional.size() < 4) {
+        cout << "usage: benchmark <path to dpll_solver> <timeout in seconds> <results file> <cnf files or directories> [--jobs N] [--baseline FILE] [--tolerance T] [--plot FILE] [--seed S] [--check-proofs CHECKER] [--repeat N] [--extended]\n";
+        exit(1);
+    }
+    string solver = positional[0];
+    double timeout = atof(positional[1].c_str());
+    string results_path = positional[2];
+
+    // A directory stands for the cnf files in it, in alphabetical order.
+    vector<string> files;
+    for (size_t i = 3; i < positional.size(); ++i) {
+        if (!filesystem::is_directory(positional[i])) {
+            files.push_back(positional[i]);
+            continue;
+        }
+        vector<string> dir_files;
+        for (auto& entry: filesystem::directory_iterator(positional[i])) {
+            string name = entry.path().string();
+            if (name.find(".cnf") != string::npos) { dir_files.push_back(name); }
+        }
+        sort(dir_files.begin(), dir_files.end());
+        files.insert(files.end(), dir_files.begin(), dir_files.end());
+    }
+    vector<pair<string, vector<string>>> configs = basic_configs;
+    if (extended) { configs.insert(configs.end(), extended_configs.begin(), extended_configs.end()); }
+
+    // The workers take the runs in a fixed order, and every run is stored at its own index, so the results do not depend on the scheduling.
+    vector<Run> runs(configs.size() * files.size());
+    atomic<size_t> next_run(0);
+    mutex print_mutex;
+    vector<thread> workers;
+    for (int w = 0; w < jobs; ++w) {
+        workers.emplace_back([&]() {
+            for (size_t i = next_run++; i < runs.size(); i = next_run++) {
+                auto& config = configs[i / files.size()];
+                // Pure literal elimination cannot write a proof.
+                string proof_path;
+                if (!checker.empty() && find(config.second.begin(), config.second.end(), "-p") == config.second.end()) {
+                    proof_path = (filesystem::temp_directory_path() / ("dpll_proof_" + to_string(getpid()) + "_" + to_string(i))).string();
+                }
+                vector<Run> repetitions;
+                for (int r = 0; r < repeat; ++r) { repetitions.push_back(run_solver(solver, config, files[i % files.size()], timeout, seed, checker, proof_path)); }
+                runs[i] = median_run(repetitions);
+                lock_guard<mutex> lock(print_mutex);
+                cerr << "[" << i+1 << "/" << runs.size() << "] " << runs[i].config << " " << runs[i].file << ": " << runs[i].result << " " << runs[i].cpu_time << "s\n";
+            }
+        });
+    }
+    for (thread& t: workers) { t.join(); }
+    write_csv(results_path, runs);
+    if (!plot_path.empty()) { write_plot_json(plot_path, configs, runs); }
+
+    // Compare with the baseline on the files that both runs contain.
+    map<pair<string, string>, const Run*> baseline;
+    vector<Run> baseline_runs;
+    if (!baseline_path.empty()) {
+        baseline_runs = read_csv(baseline_path);
+        for (const Run& run: baseline_runs) { baseline[{run.config, run.file}] = &run; }
+    }
+    bool regression = false;
+    cout << left << setw(28) << "configuration" << setw(10) << "solved" << setw(12) << "PAR-2" << setw(12) << "peak RSS";
+    if (!baseline.empty()) { cout << setw(12) << "baseline" << "change"; }
+    cout << "\n" << fixed << setprecision(3);
+    for (auto& config: configs) {
+        vector<const Run*> config_runs;
+        vector<const Run*> baseline_config_runs;
+        vector<string> problems;
+        int solved = 0;
+        long peak_rss = 0;
+        for (const Run& run: runs) {
+            if (run.config != config.first) { continue; }
+            config_runs.push_back(&run);
+            solved += run.result == "sat" || run.result == "unsat";
+            peak_rss = max(peak_rss, run.peak_rss);
+            if (run.result == "wrong" || run.result == "error") { problems.push_back(run.result + " on " + run.file); }
+            auto old = baseline.find({run.config, run.file});
+            if (old == baseline.end()) { continue; }
+            baseline_config_runs.push_back(old->second);
+            bool old_solved = old->second->result == "sat" || old->second->result == "unsat";
+            bool new_solved = run.result == "sat" || run.result == "unsat";
+            if (old_solved && new_solved && old->second->result != run.result) { problems.push_back("answer changed on " + run.file); }
+            if (old_solved && !new_solved) { problems.push_back("no longer solved: " + run.file); }
+        }
+        double score = par2(config_runs, timeout);
+        cout << setw(28) << config.first << setw(10) << (to_string(solved) + "/" + to_string(config_runs.size())) << setw(12) << score << setw(12) << (to_string(peak_rss / 1024) + " MiB");
+        if (!baseline_config_runs.empty()) {
+            // Only the runs that also exist in the baseline are compared.
+            vector<const Run*> compared;
+            for (const Run* run: config_runs) {
+                if (baseline.count({run->config, run->file})) { compared.push_back(run); }
+            }
+            double old_score = par2(baseline_config_runs, timeout);
+            double new_score = par2(compared, timeout);
+            double change = (old_score > 0) ? (new_score - old_score) / old_score : 0;
+            cout << setw(12) << old_score << showpos << change * 100 << "%" << noshowpos;
+            if (change > tolerance) { problems.push_back("PAR-2 increased by more than " + to_string((int)(tolerance * 100)) + "%"); }
+        }
+        cout << "\n";
+        for (string& problem: problems) { cout << "    REGRESSION: " << problem << "\n"; }
+        regression = regression || !problems.empty();
+    }
+    return regression ? 1 : 0;
+}
@@ -1,16 +1,85 @@
 #include "dpll_solver.h"
 
-vector<Variable> variables;
-deque<Clause> clauses;  // uses deque instead of vector to avoid dangling pointers
-vector<pair<Variable*, Mark>> assignments;
-vector<Clause*> unit_clauses;
-bool use_pure_lit = false;
-vector<Variable*> pure_lits;
-Heap unassigned_vars;
-int counter = 0;
-Heuristic heu = Heuristic::none;  // The default setting is without any heuristics.
-bool update_active_occ = false;  // only update active occurrences when needed
+size_t ArenaMemory::spill_threshold = numeric_limits<size_t>::max();
+atomic<size_t> ArenaMemory::allocated{0};
+atomic<size_t> ArenaMemory::peak{0};
+atomic<size_t> ArenaMemory::spilled{0};
+atomic<size_t> ArenaMemory::peak_spilled{0};
+mutex ArenaMemory::m;
+vector<pair<void*, size_t>> ArenaMemory::mapped;
 
+// Raise a peak counter to a new value unless another thread has raised it further.
+static void raise_peak(atomic<size_t>& peak, size_t value) {
+    size_t old = peak.load();
+    while (value > old && !peak.compare_exchange_weak(old, value)) {}
+}
+
+// Map a new temporary file of the given size, which is deleted as soon as it is unmapped. Return nullptr if that fails.
+void* ArenaMemory::map_file(size_t bytes) {
+    const char* dir = getenv("TMPDIR");
+    string path = string((dir != nullptr) ? dir : "/tmp") + "/dpll_clauses_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) { return nullptr; }
+    unlink(path.c_str());
+    void* block = MAP_FAILED;
+    if (ftruncate(fd, bytes) == 0) { block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0); }
+    ::close(fd);
+    return (block == MAP_FAILED) ? nullptr : block;
+}
+
+// Allocate a block for an arena. A block that cannot be placed in a file is allocated normally.
+void* ArenaMemory::allocate(size_t bytes) {
+    void* block = nullptr;
+    if (bytes >= spill_threshold && (block = map_file(bytes)) != nullptr) {
+        lock_guard<mutex> lock(m);
+        mapped.push_back({block, bytes});
+        raise_peak(peak_spilled, spilled += bytes);
+    } else {
+        block = malloc(bytes);
+        if (block == nullptr) { throw bad_alloc(); }
+    }
+    raise_peak(peak, allocated += bytes);
+    return block;
+}
+
+void ArenaMemory::deallocate(void* block, size_t bytes) {
+    allocated -= bytes;
+    if (bytes >= spill_threshold) {
+        lock_guard<mutex> lock(m);
+        auto it = find_if(mapped.begin(), mapped.end(), [block](auto& entry) { return entry.first == block; });
+        if (it != mapped.end()) {
+            munmap(block, bytes);
+            spilled -= bytes;
+            *it = mapped.back();
+            mapped.pop_back();
+            return;
+        }
+    }
+    free(block);
+}
+
+// Append a clause to the arena.
+CRef ClauseArena::alloc(const vector<int>& lits, bool learnt) {
+    assert(memory.size() + clause_header_words + lits.size() < no_clause);
+    CRef cr = memory.size();
+    memory.resize(memory.size() + clause_header_words + lits.size());
+    Clause& cl = (*this)[cr];
+    cl.size = lits.size();
+    cl.active = lits.size();
+    cl.sat_var = 0;
+    cl.learnt = learnt;
+    cl.deleted = false;
+    cl.lbd = 0;
+    copy(lits.begin(), lits.end(), cl.begin());
+    return cr;
+}
+
+// Mark a clause as deleted. Its memory is reclaimed by the next garbage collection.
+void ClauseArena::free(CRef cr) {
+    Clause& cl = (*this)[cr];
+    cl.deleted = true;
+    wasted += words(cl);
+}
 
 // Append a variable to the heap and re-sort the heap.
 void Heap::insert(Variable* var) {
@@ -24,16 +93,22 @@ void Heap::remove(Variable* var) {
     Variable* end_var = heap[heap.size()-1];
     swap(heap[var->heap_position], heap[heap.size()-1]);  // First swap the to-be-removed variable with the last variable.
     heap.pop_back();
-    end_var->heap_position = var->heap_position;
-    move_down(end_var);
+    if (end_var != var) {
+        end_var->heap_position = var->heap_position;
+        move_up(end_var);
+        move_down(end_var);
+    }
+    var->heap_position = 0;
 }
 
 // When a variable's priority is bigger than its parent's, it percolates up in the heap.
 void Heap::move_up(Variable* var) {
+    STAT(++stats->heap_moves);
     int var_ind = var->heap_position;
     while (var_ind > 1) {
         Variable* parent = heap[parent_ind(var_ind)];
-        if (greater_than(var, parent)) {
+        if (greater_than(var, parent, heu)) {
+            STAT(++stats->heap_swaps);
             swap(heap[var_ind], heap[parent_ind(var_ind)]);
             parent->heap_position = var_ind;
             var_ind = parent_ind(var_ind);
@@ -44,12 +119,14 @@ void Heap::move_up(Variable* var) {
 
 // When a variable's priority is smaller than its children's, it percolates down in the heap.
 void Heap::move_down(Variable* var) {
+    STAT(++stats->heap_moves);
     int var_ind = var->heap_position;
     while (true) {
         int max_child_ind = this->max_child_ind(var_ind);
-        if (var_ind == max_child_ind || !greater_than(heap[max_child_ind], heap[var_ind])) { 
+        if (var_ind == max_child_ind || !greater_than(heap[max_child_ind], heap[var_ind], heu)) { 
             break;
         } else {
+            STAT(++stats->heap_swaps);
             swap(heap[var_ind], heap[max_child_ind]);
             heap[var_ind]->heap_position = var_ind;
             var_ind = max_child_ind;
@@ -58,516 +135,2267 @@ void Heap::move_down(Variable* var) {
     heap[var_ind]->heap_position = var_ind;
 }
 
-Variable* Heap::max() {
-    return this->heap[1];
+// Mark a variable whose priority may have changed or that has been unassigned. It is only repositioned by the next repair.
+void Heap::touch(Variable* var) {
+    if (!var->heap_dirty) {
+        var->heap_dirty = true;
+        dirty.push_back(var);
+    }
 }
 
-// Return the number of occurrences (search->second) if the clause length (key of m) is found, otherwise return 0.
-int get_or_default(const map<int,int>& m, int l) {
-    auto search = m.find(l);
-    if (search != m.end()) { return search->second; }
-    return 0;
+// Recompute the priorities of the dirty variables one by one and move them to their places, reinserting the ones that have been removed. Assigned variables keep their old priority and position until they are unassigned again.
+void Heap::repair() {
+    for (Variable* var: dirty) {
+        var->heap_dirty = false;
+        if (var->value != Value::unset) { continue; }
+        var->update_priority(heu);
+        if (var->heap_position == 0) {
+            insert(var);
+        } else {
+            move_up(var);
+            move_down(var);
+        }
+    }
+    dirty.clear();
 }
 
-// Compute the mom-heuristic score for variable v.
-double mom_helper(Variable* v, int len, int alpha) {
-    double pos_cl_count = get_or_default(v->pos_by_cl_len, len);
-    double neg_cl_count = get_or_default(v->neg_by_cl_len, len);
-    return (pos_cl_count + neg_cl_count) * pow(2, alpha) + pos_cl_count * neg_cl_count;
+// Restore the heap property after the priorities of many variables have changed, by moving the inner nodes down from the last one to the root.
+void Heap::rebuild() {
+    for (int i = (heap.size()-1) / 2; i >= 1; --i) { move_down(heap[i]); }
 }
 
-// Increment the iterator if it points to the clause length l.
-map<int,int>::iterator it_incr(const map<int,int>& m, map<int,int>::iterator it, int l) {
-    if (it != m.end() && it->first == l) { return ++it; }
-    return it;
+// Return the unassigned variable of highest priority. Assigned variables that come to the top on the way are removed. There has to be at least one unassigned variable.
+Variable* Heap::max() {
+    repair();
+    while (heap[1]->value != Value::unset) { remove(heap[1]); }
+    return heap[1];
 }
 
-// Different ways to compare priorities of literals/variables.
-bool greater_than(Variable* v1, Variable* v2) {
+// Pack a heuristic's score at the shortest clause length len and a second score into one priority, which compares lexicographically: first shorter clause lengths, then higher scores. Each score is capped at 20 bits, so that the priority is an exact double. When the first score is capped, the second one is dropped, so that ties are broken by the exact comparison.
+double pack_priority(int len, int score1, int score2) {
+    const int max_score = (1 << 20) - 1;
+    if (score1 >= max_score) { score2 = 0; }
+    return ldexp(4096 - min(len, 4096), 40) + ldexp(min(score1, max_score), 20) + min(score2, max_score);
+}
+
+// Compute the boehm-heuristic score of a variable for the clauses of length len.
+int boehm_score(Variable* v, int len) {
+    const int alpha = 1;
+    const int beta = 2;
+    int pos_count = v->pos_by_cl_len.count(len);
+    int neg_count = v->neg_by_cl_len.count(len);
+    return alpha * max(pos_count, neg_count) + beta * min(pos_count, neg_count);
+}
+
+// Recompute the cached priority of a variable after its counts have changed. The heap only compares these priorities.
+void Variable::update_priority(Heuristic heu) {
     switch(heu) {
         case Heuristic::slis:
             // Static Literal Individual Sum: Compare literals according to their number of occurrences. It does not keep track of the change of clauses, therefore the priority value of each literal is not modified anymore once the heap is established.
-            return max(v1->pos_occ.size(), v1->neg_occ.size()) > max(v2->pos_occ.size(), v2->neg_occ.size());
+            priority = max(pos_count, neg_count);
+            break;
         case Heuristic::slcs:
             // Static Literal Combined Sum: Compare variables according to their number of occurrences (both as positive and negative literals).
-            return v1->pos_occ.size() + v1->neg_occ.size() > v2->pos_occ.size() + v2->neg_occ.size();
+            priority = pos_count + neg_count;
+            break;
         case Heuristic::dlis:
             // Compare literals according to their number of occurrences in active clauses.
-            return max(v1->active_pos_occ, v1->active_neg_occ) > max(v2->active_pos_occ, v2->active_neg_occ);
+            priority = max(active_pos_occ, active_neg_occ);
+            break;
         case Heuristic::dlcs:
             // Compare variables according to their number of occurrences in active clauses.
-            return v1->active_pos_occ + v1->active_neg_occ > v2->active_pos_occ + v2->active_neg_occ;
+            priority = active_pos_occ + active_neg_occ;
+            break;
         case Heuristic::backtrack_count:
             // Compare variables according to how many times they have been backtracked.
-            return v1->backtrack_count > v2->backtrack_count;
+            priority = backtrack_count;
+            break;
         case Heuristic::mom: {
-            // Compare variables according to their mom-heuristic scores regarding the minimal clause length.
-            const int alpha = 50;
-            
-            // Among all the active clauses that contain at least one of v1 and v2, find the length of the shortest clause.
-            int cl_len = numeric_limits<int>::max();
-            if (v1->pos_by_cl_len.begin() != v1->pos_by_cl_len.end()) {  // check if the map is empty
-                cl_len = min(cl_len, v1->pos_by_cl_len.begin()->first);
-            }
-            if (v1->neg_by_cl_len.begin() != v1->neg_by_cl_len.end()) {
-                cl_len = min(cl_len, v1->neg_by_cl_len.begin()->first);
-            }
-            if (v2->pos_by_cl_len.begin() != v2->pos_by_cl_len.end()) {
-                cl_len = min(cl_len, v2->pos_by_cl_len.begin()->first);
-            }
-            if (v2->neg_by_cl_len.begin() != v2->neg_by_cl_len.end()) {
-                cl_len = min(cl_len, v2->neg_by_cl_len.begin()->first);
+            // Compare variables according to their mom-heuristic scores regarding the minimal clause length. A variable that occurs in a shorter clause always wins, because the other one has a score of zero for that length. The score (pos+neg) * 2^alpha + pos*neg with alpha = 50 orders variables by pos+neg first and then by pos*neg.
+            int len = min(pos_by_cl_len.min_len, neg_by_cl_len.min_len);
+            if (len == ClauseLengths::none) {
+                priority = 0;
+            } else {
+                int pos_count = pos_by_cl_len.count(len);
+                int neg_count = neg_by_cl_len.count(len);
+                priority = pack_priority(len, pos_count + neg_count, min((long long)pos_count * neg_count, (long long)numeric_limits<int>::max()));
             }
-
-            double v1_heu = mom_helper(v1, cl_len, alpha);
-            double v2_heu = mom_helper(v2, cl_len, alpha);
-            return v1_heu > v2_heu;
+            break;
         }
         case Heuristic::boehm: {
-            // Compare variables according to their boehm-heuristic scores lexicographically.
-            const int alpha = 1;
-            const int beta = 2;
-
-            // Among all the active clauses that contain at least one of v1 and v2, find the length of the shortest clause. Increase the length until the boehm-heuristic scores of v1 and v2 are different.
-            auto v1_pos = v1->pos_by_cl_len.begin();
-            auto v1_neg = v1->neg_by_cl_len.begin();
-            auto v2_pos = v2->pos_by_cl_len.begin();
-            auto v2_neg = v2->neg_by_cl_len.begin();
-            while (true) {
-                int cl_len = numeric_limits<int>::max();
-                if (v1_pos != v1->pos_by_cl_len.end()) {
-                    cl_len = v1_pos->first;
-                }
-                if (v1_neg != v1->neg_by_cl_len.end()) {
-                    cl_len = min(cl_len, v1_neg->first);
-                }
-                if (v2_pos != v2->pos_by_cl_len.end()) {
-                    cl_len = min(cl_len, v2_pos->first);
-                }
-                if (v2_neg != v2->neg_by_cl_len.end()) {
-                    cl_len = min(cl_len, v2_neg->first);
-                }
-                
-                // If the heuristic scores of v1 and v2 regarding all the occurring clause lengths are the same, return false.
-                if (cl_len == numeric_limits<int>::max()) { return false; }
-
-                // Compute the boehm-heuristic scores.
-                int v1_pos_count = get_or_default(v1->pos_by_cl_len, cl_len);
-                int v1_neg_count = get_or_default(v1->neg_by_cl_len, cl_len);
-                int v2_pos_count = get_or_default(v2->pos_by_cl_len, cl_len);
-                int v2_neg_count = get_or_default(v2->neg_by_cl_len, cl_len);
-                int v1_max = max(v1_pos_count, v1_neg_count);
-                int v1_min = min(v1_pos_count, v1_neg_count);
-                int v2_max = max(v2_pos_count, v2_neg_count);
-                int v2_min = min(v2_pos_count, v2_neg_count);
-                double v1_heu = alpha * v1_max + beta * v1_min;
-                double v2_heu = alpha * v2_max + beta * v2_min;
-                if (v1_heu != v2_heu) { return v1_heu > v2_heu; };
-
-                // Increment the iterators that point to cl_len.
-                v1_pos = it_incr(v1->pos_by_cl_len, v1_pos, cl_len);
-                v1_neg = it_incr(v1->neg_by_cl_len, v1_neg, cl_len);
-                v2_pos = it_incr(v2->pos_by_cl_len, v2_pos, cl_len);
-                v2_neg = it_incr(v2->neg_by_cl_len, v2_neg, cl_len);
-            }
+            // Compare variables according to their boehm-heuristic scores lexicographically, starting from the minimal clause length. The priority covers the two shortest lengths, ties are broken by greater_than.
+            int len = min(pos_by_cl_len.min_len, neg_by_cl_len.min_len);
+            priority = (len == ClauseLengths::none) ? 0 : pack_priority(len, boehm_score(this, len), boehm_score(this, len+1));
+            break;
         }
         case Heuristic::jw:
             // Compare literals according to their Jeroslow-Wang heuristic scores
-            return max(v1->jw_pos, v1->jw_neg) > max(v2->jw_pos, v2->jw_neg);
+            priority = max(jw_pos, jw_neg);
+            break;
+        case Heuristic::lookahead:
+            // Lookahead does not use the heap, but preselects its candidates by the combined Jeroslow-Wang scores.
+            priority = jw_pos + jw_neg;
+            break;
         case Heuristic::none:
-            // Pick a variable randomly
-            return rand() % 2 == 0;
+            // The variables keep the random priorities they got at the start.
+            break;
+    }
+}
+
+// Compare the priorities of two variables in the heap.
+bool greater_than(Variable* v1, Variable* v2, Heuristic heu) {
+    if (v1->priority != v2->priority) { return v1->priority > v2->priority; }
+    if (heu != Heuristic::boehm) { return false; }
+
+    // The priorities only cover Boehm's scores for the two shortest clause lengths. Compare the scores for all lengths lexicographically.
+    int cl_len = min(min(v1->pos_by_cl_len.min_len, v1->neg_by_cl_len.min_len), min(v2->pos_by_cl_len.min_len, v2->neg_by_cl_len.min_len));
+    int max_len = max(max(v1->pos_by_cl_len.max_len, v1->neg_by_cl_len.max_len), max(v2->pos_by_cl_len.max_len, v2->neg_by_cl_len.max_len));
+    for (; cl_len <= max_len; ++cl_len) {
+        int v1_heu = boehm_score(v1, cl_len);
+        int v2_heu = boehm_score(v2, cl_len);
+        if (v1_heu != v2_heu) { return v1_heu > v2_heu; }
     }
+    // The heuristic scores of v1 and v2 regarding all the occurring clause lengths are the same.
+    return false;
 }
 
 // Pick a polarity for a variable.
-Value pick_polarity(Variable* v) {
+Value Solver::pick_polarity(Variable* v) {
+    // With restarts, a variable takes its last value again, so that a restart does not throw away the progress towards a model.
+    if (restart != Restart::none && v->saved_phase != Value::unset) { return v->saved_phase; }
     switch(heu) {
+        // The backtrack count does not keep the active occurrences, which pure literal elimination no longer maintains for it either.
         case Heuristic::slis:
         case Heuristic::slcs:
-            return (v->pos_occ.size() > v->neg_occ.size()) ? Value::t : Value::f;
+        case Heuristic::backtrack_count:
+            return (v->pos_count > v->neg_count) ? Value::t : Value::f;
         case Heuristic::dlis:
         case Heuristic::dlcs:
-        case Heuristic::backtrack_count:
         case Heuristic::mom:
         case Heuristic::boehm:
             return (v->active_pos_occ > v->active_neg_occ) ? Value::t : Value::f;
         case Heuristic::jw:
+        case Heuristic::lookahead:
             return (v->jw_pos > v->jw_neg) ? Value::t : Value::f;
         case Heuristic::none:
-            return rand()%2 == 0 ? Value::t : Value::f;
+            return rng.coin() ? Value::t : Value::f;
     }
 }
 
-// For assertion: Check if the number of occurrences in pos_by_cl_len and pos_by_cl_len are correct.
-bool is_consistent(Variable* v) {
+// For assertion: Check if the number of occurrences in pos_by_cl_len and neg_by_cl_len are correct. Only MOM and Boehm keep track of them.
+bool Solver::is_consistent(Variable* v) {
+    if (heu != Heuristic::mom && heu != Heuristic::boehm) { return true; }
     int pos_sum = 0;
     int neg_sum = 0;
-    for (pair<int,int> p: v->pos_by_cl_len) { pos_sum += p.second; }
-    for (pair<int,int> p: v->neg_by_cl_len) { neg_sum += p.second; }
+    for (int len = 1; len <= v->pos_by_cl_len.max_len; ++len) { pos_sum += v->pos_by_cl_len.count(len); }
+    for (int len = 1; len <= v->neg_by_cl_len.max_len; ++len) { neg_sum += v->neg_by_cl_len.count(len); }
     return pos_sum == v->active_pos_occ && neg_sum == v->active_neg_occ;
 }
 
+// Return the value of a literal under the current assignment.
+Value Solver::lit_value(int lit) {
+    return Value(values_by_lit()[lit]);
+}
+
+static int first_not_false_scalar(const int* lits, int begin, int end, const uint8_t* values) {
+    while (begin < end && values[lits[begin]] == uint8_t(Value::f)) { ++begin; }
+    return begin;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static int first_not_false_avx2(const int* lits, int begin, int end, const uint8_t* values) {
+    const __m256i low_byte = _mm256_set1_epi32(0xFF);
+    const __m256i false_value = _mm256_set1_epi32(int(Value::f));
+    for (; begin + 8 <= end; begin += 8) {
+        // The literals themselves are the byte offsets of their values.
+        __m256i lit_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lits + begin));
+        __m256i value_vec = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(values), lit_vec, 1), low_byte);
+        unsigned is_false = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(value_vec, false_value)));
+        if (is_false != 0xFF) { return begin + __builtin_ctz(~is_false); }
+    }
+    return first_not_false_scalar(lits, begin, end, values);
+}
+#endif
+
+// Choose the kernel once for the CPU the solver runs on.
+static auto select_first_not_false() -> int (*)(const int*, int, int, const uint8_t*) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) { return first_not_false_avx2; }
+#endif
+    return first_not_false_scalar;
+}
+
+int (*first_not_false)(const int*, int, int, const uint8_t*) = select_first_not_false();
+
+// Return the position of the first literal from cl[begin] on that is not false, or cl.size. Short scans stay inline.
+int Solver::scan_not_false_scalar(Clause& cl, int begin) {
+    return first_not_false_scalar(cl.begin(), begin, cl.size, values_by_lit());
+}
+
+// Return the list of clauses that watch a literal.
+vector<CRef>& Solver::watch_list(int lit) {
+    return (lit > 0) ? variables[lit].pos_watch : variables[-lit].neg_watch;
+}
+
+// Visit only the clauses that watch the literal falsified by the variable's new value. Each of them either finds a new literal to watch, becomes a unit clause or is conflicting.
+void Solver::update_watches(Variable* v) {
+    int var_ind = index_of(v);
+    int false_lit = (v->value == Value::t) ? -var_ind : var_ind;
+    vector<CRef>& watches = watch_list(false_lit);
+    size_t i = 0;
+    size_t j = 0;  // watches[0..j) are the clauses that keep watching false_lit
+    STAT(stats.clause_visits += watches.size());
+    while (i < watches.size()) {
+        CRef cr = watches[i++];
+        Clause& cl = clauses[cr];
+        // Make sure that the falsified literal is cl[1].
+        if (cl[0] == false_lit) { swap(cl[0], cl[1]); }
+        // The clause is already satisfied by the other watched literal.
+        if (lit_value(cl[0]) == Value::t) {
+            watches[j++] = cr;
+            continue;
+        }
+        // Look for a literal that is not false and watch it instead.
+        int k = scan_not_false(cl, 2);
+        if (k < cl.size) {
+            swap(cl[1], cl[k]);
+            watch_list(cl[1]).push_back(cr);
+            continue;
+        }
+
+        // All the other literals are false, therefore the clause is either unit or conflicting.
+        watches[j++] = cr;
+        if (lit_value(cl[0]) == Value::unset) {
+            unit_clauses.push_back(cr);
+        } else {
+            conflict_clause = cr;
+            while (i < watches.size()) { watches[j++] = watches[i++]; }
+            break;
+        }
+    }
+    watches.resize(j);
+}
+
 // Assign truth value to a variable.
-void Variable::set(Value new_value, Mark mark) {
-    assignments.push_back(make_pair(this, mark));
-    value = new_value;
-    unassigned_vars.remove(this);
-    bool found_conflict = false;
-    for (Clause* cl: (value == Value::t) ? pos_occ : neg_occ) {
-        if (cl->sat_var == nullptr) {
-            cl->sat_var = this;
-            if (heu == Heuristic::jw) {
+void Solver::set(Variable* v, Value new_value, Mark mark, CRef reason) {
+    STAT(++stats.assignments);
+    assignments.push_back(make_pair(v, mark));
+    v->value = new_value;
+    int var_ind = index_of(v);
+    values_by_lit()[var_ind] = uint8_t(new_value);
+    values_by_lit()[-var_ind] = uint8_t((new_value == Value::t) ? Value::f : Value::t);
+    v->level = level_begin.size();
+    v->reason = reason;
+    // The variable stays in the heap and is only removed when it reaches the top.
+    if (use_watched) {
+        update_watches(v);
+        return;
+    }
+    STAT(stats.clause_visits += v->pos_occ.size() + v->neg_occ.size());
+    (this->*count_assignment)(v);
+}
+
+// Update the active clauses and the counts of the heuristic after a variable has been assigned.
+template<class Policy>
+void Solver::count_set(Variable* v) {
+    for (CRef cr: (v->value == Value::t) ? v->pos_occ : v->neg_occ) {
+        Clause& cl = clauses[cr];
+        if (cl.sat_var == 0) {
+            cl.sat_var = index_of(v);
+            if constexpr (Policy::jw) {
                 // Since the clause is now satisfied, the occurrences of all the unassigned literals in the clause should no longer be counted towards the Jeroslow-Wang heuristic score. 
-                for (int lit: cl->lits) {
-                    Variable* var = &variables[abs(lit)];
-                    if (var->value == Value::unset) { 
-                        (lit > 0 ? var->jw_pos : var->jw_neg) -= pow(2, -cl->active);
-                        unassigned_vars.move_down(var);
+                for (int lit: cl) {
+                    if (lit_value(lit) == Value::unset) {
+                        Variable* var = &variables[abs(lit)];
+                        (lit > 0 ? var->jw_pos : var->jw_neg) -= jw_weight(cl.active);
+                        unassigned_vars.touch(var);
                     }
                 }
             }
-            if (update_active_occ) {
-                for (int lit: cl->lits) {
-                    Variable* var = &variables[abs(lit)];
-                    if (var->value == Value::unset) {
+            if constexpr (Policy::active_occ) {
+                for (int lit: cl) {
+                    if (lit_value(lit) == Value::unset) {
+                        Variable* var = &variables[abs(lit)];
                         // The literal's number of occurrences decreases by one, because the clause is satisfied, therefore deactivated.
-                        // Every variable will be appended to pure_lits at most twice.
-                        if (lit > 0) {
-                            var->active_pos_occ -= 1;
-                            if (use_pure_lit && var->active_pos_occ == 0) {
-                                pure_lits.push_back(var);
-                            }
-                        } else {
-                            var->active_neg_occ -= 1;
-                            if (use_pure_lit && var->active_neg_occ == 0) {
-                                pure_lits.push_back(var);
-                            }
-                        }
+                        (lit > 0 ? var->active_pos_occ : var->active_neg_occ) -= 1;
                         assert(var->active_pos_occ >= 0 && var->active_neg_occ >= 0);
 
-                        // Decrement the number of clauses of length cl->active, because the clause is satisfied. Delete the pair from the map if the literal does not appear in clauses of this length anymore.
-                        if (heu == Heuristic::mom || heu == Heuristic::boehm) {
-                            map<int,int>& m = lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len;
-                            auto search = m.find(cl->active);
-                            if (search->second != 1) { search->second -= 1; }
-                            else { m.erase(search); }
+                        // Decrement the number of clauses of length cl.active, because the clause is satisfied.
+                        if constexpr (Policy::by_cl_len) {
+                            (lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len).remove(cl.active);
                             assert(is_consistent(var));
                         }
                         // Since the variable's number of occurrences decreased, the priority can only decrease.
-                        unassigned_vars.move_down(var);
+                        unassigned_vars.touch(var);
                     }
                 }
             }
         }
     }
-    for (Clause* cl: (value == Value::t) ? neg_occ : pos_occ) {
-        if (cl->sat_var == nullptr) {
-            cl->active -= 1;
-            if (heu == Heuristic::mom || heu == Heuristic::boehm || heu == Heuristic::jw) {
-                for (int lit: cl->lits) {
-                    Variable* var = &variables[abs(lit)];
-                    if (var->value == Value::unset) {
-                        if (heu == Heuristic::jw) {
+    for (CRef cr: (v->value == Value::t) ? v->neg_occ : v->pos_occ) {
+        Clause& cl = clauses[cr];
+        if (cl.sat_var == 0) {
+            cl.active -= 1;
+            if constexpr (Policy::jw || Policy::by_cl_len) {
+                for (int lit: cl) {
+                    if (lit_value(lit) == Value::unset) {
+                        Variable* var = &variables[abs(lit)];
+                        if constexpr (Policy::jw) {
                             // The literal now occurs in a shorter clause, therefore add the difference to the Jeroslow-Wang heuristic score.
-                            (lit > 0 ? var->jw_pos : var->jw_neg) += pow(2, -(cl->active+1));
+                            (lit > 0 ? var->jw_pos : var->jw_neg) += jw_weight(cl.active) - jw_weight(cl.active+1);
                         } else {
-                        // The variable var is now in a clause with one fewer active literal, update the counts accordingly.  
-                        map<int,int>& m = lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len;
-                        auto search = m.find(cl->active+1);
-                        if (search->second != 1) { search->second -= 1; }
-                        else { m.erase(search); }
-                        m[cl->active] += 1;
+                            // The variable var is now in a clause with one fewer active literal, update the counts accordingly.
+                            (lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len).shrink(cl.active+1);
                         }
                         // The clause that the variable appears in becomes shorter. Since our heuristics favor clauses of shorter length, the priority of the variable may increase.
-                        unassigned_vars.move_up(var);
+                        unassigned_vars.touch(var);
                         assert(is_consistent(var));
                     }
                 }
             }
-            if (cl->active == 1) { unit_clauses.push_back(cl); } 
-            else if (cl->active == 0) { found_conflict = true; }
+            if (cl.active == 1) { unit_clauses.push_back(cr); } 
+            else if (cl.active == 0) { conflict_clause = cr; }
         }
     }
-    if (found_conflict) {
-        if (heu == Heuristic::backtrack_count) {
-            if (counter < 200) {
-                counter++;
-            } else {
-                counter = 0;
-                for (Variable& var: variables) {
-                    var.backtrack_count /= 2;
-                }
-            }
-        }
-        backtrack();
-    }
 }
 
 // Unassign truth value of a variable.
-void Variable::unset() {
-    for (Clause* cl: (value == Value::t) ? pos_occ : neg_occ) {
-        if (cl->sat_var == this) {
-            cl->sat_var = nullptr;
-            if (heu == Heuristic::jw) {
+void Solver::unset(Variable* v) {
+    // With watched literals, the watches stay valid when a variable is unassigned, therefore no clause needs to be visited.
+    v->saved_phase = v->value;
+    if (!use_watched) { (this->*count_unassignment)(v); }
+    v->value = Value::unset;
+    values_by_lit()[index_of(v)] = values_by_lit()[-index_of(v)] = uint8_t(Value::unset);
+    unassigned_vars.touch(v);
+}
+
+// Reactivate the clauses and restore the counts of the heuristic before a variable is unassigned.
+template<class Policy>
+void Solver::count_unset(Variable* v) {
+    for (CRef cr: (v->value == Value::t) ? v->pos_occ : v->neg_occ) {
+        Clause& cl = clauses[cr];
+        if (cl.sat_var == index_of(v)) {
+            cl.sat_var = 0;
+            if constexpr (Policy::jw) {
                 // Since the clause is now reactivated, the occurrences of all the unassigned literals in the clause should again be counted towards the Jeroslow-Wang heuristic score. 
-                for (int lit: cl->lits) {
-                    Variable* var = &variables[abs(lit)];
-                    if (var->value == Value::unset) {
-                        (lit > 0 ? var->jw_pos : var->jw_neg) += pow(2, -cl->active);
-                        unassigned_vars.move_up(var);
+                for (int lit: cl) {
+                    if (lit_value(lit) == Value::unset) {
+                        Variable* var = &variables[abs(lit)];
+                        (lit > 0 ? var->jw_pos : var->jw_neg) += jw_weight(cl.active);
+                        unassigned_vars.touch(var);
                     }
                 }                 
             }
-            if (update_active_occ) {
-                for (int lit: cl->lits) {
-                    Variable* var = &variables[abs(lit)];
-                    if (var->value == Value::unset) {
+            if constexpr (Policy::active_occ) {
+                for (int lit: cl) {
+                    if (lit_value(lit) == Value::unset) {
+                        Variable* var = &variables[abs(lit)];
                         // The variable's number of occurrences increases by one, because the variable that satistifed the clause is unset, therefore the clause is active again.
                         (lit > 0 ? var->active_pos_occ : var->active_neg_occ) += 1;
 
-                        if (heu == Heuristic::mom || heu == Heuristic::boehm) {
-                            (lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len)[cl->active] += 1;
+                        if constexpr (Policy::by_cl_len) {
+                            (lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len).add(cl.active);
                             assert(is_consistent(var));
                         }
 
                         // Since the variable's number of occurrences increased, the priority can only increase.
-                        unassigned_vars.move_up(var);
+                        unassigned_vars.touch(var);
                     }
                 }
             }
         }
     }
-    for (Clause* cl: (value == Value::t) ? neg_occ : pos_occ) {
-        if (cl->sat_var == nullptr) {
-            cl->active += 1;
-            if (heu == Heuristic::mom || heu == Heuristic::boehm || heu == Heuristic::jw) {
-                for (int lit: cl->lits) {
-                    Variable* var = &variables[abs(lit)];
-                    if (var->value == Value::unset) {
-                        if (heu == Heuristic::jw) {
+    for (CRef cr: (v->value == Value::t) ? v->neg_occ : v->pos_occ) {
+        Clause& cl = clauses[cr];
+        if (cl.sat_var == 0) {
+            cl.active += 1;
+            if constexpr (Policy::jw || Policy::by_cl_len) {
+                for (int lit: cl) {
+                    if (lit_value(lit) == Value::unset) {
+                        Variable* var = &variables[abs(lit)];
+                        if constexpr (Policy::jw) {
                             // The literal now occurs in a longer clause, therefore subtract the difference from the Jeroslow-Wang heuristic score.
-                            (lit > 0 ? var->jw_pos : var->jw_neg) -= pow(2, -cl->active);
+                            (lit > 0 ? var->jw_pos : var->jw_neg) -= jw_weight(cl.active-1) - jw_weight(cl.active);
                         } else {
-                            // The variable var is now in a clause with one more active literal, update the counts accordingly.                    
-                            map<int,int>& m = lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len;
-                            auto search = m.find(cl->active-1);
-                            if (search->second != 1) { search->second -= 1; }
-                            else { m.erase(search); }
-                            m[cl->active] += 1;
+                            // The variable var is now in a clause with one more active literal, update the counts accordingly.
+                            (lit > 0 ? var->pos_by_cl_len : var->neg_by_cl_len).grow(cl.active);
                         }
                         // The clause that the variables appears in becomes longer. Since our heuristics favor clauses of shorter length, the priority of the variable may decrease.
-                        unassigned_vars.move_down(var);
+                        unassigned_vars.touch(var);
                         assert(is_consistent(var));
                     }
                 }
             }
         }
     }
-    value = Value::unset;
-    unassigned_vars.insert(this);
 }
 
-void fromFile(string path) {
-    ifstream file = ifstream(path);
-    string s;
-    file >> s;
+// Point the solver to the counting code of one heuristic.
+template<Heuristic heu>
+void select_counting(Solver& solver) {
+    solver.count_assignment = &Solver::count_set<CountingPolicy<heu>>;
+    solver.count_unassignment = &Solver::count_unset<CountingPolicy<heu>>;
+}
 
-    // Read lines that start with "c" and ignore them.
-    while (s == "c") {
-        string line;
-        getline(file, line);
-        file >> s;
+// Choose the instantiation of the counting code for the configuration. This is the only place where propagation looks at the heuristic.
+void Solver::select_counting_code() {
+    switch(heu) {
+        case Heuristic::none: select_counting<Heuristic::none>(*this); break;
+        case Heuristic::slis: select_counting<Heuristic::slis>(*this); break;
+        case Heuristic::slcs: select_counting<Heuristic::slcs>(*this); break;
+        case Heuristic::dlis: select_counting<Heuristic::dlis>(*this); break;
+        case Heuristic::dlcs: select_counting<Heuristic::dlcs>(*this); break;
+        case Heuristic::backtrack_count: select_counting<Heuristic::backtrack_count>(*this); break;
+        case Heuristic::mom: select_counting<Heuristic::mom>(*this); break;
+        case Heuristic::boehm: select_counting<Heuristic::boehm>(*this); break;
+        case Heuristic::jw: select_counting<Heuristic::jw>(*this); break;
+        case Heuristic::lookahead: select_counting<Heuristic::lookahead>(*this); break;
+    }
+}
+
+// Give every literal an array of counts with one entry per clause length up to its longest clause, but at most ClauseLengths::long_len entries. All the arrays share the memory of cl_len_pool.
+void Solver::init_cl_len_counts() {
+    auto longest = [this](const vector<CRef>& occ) {
+        int max_len = 0;
+        for (CRef cr: occ) { max_len = max(max_len, clauses[cr].size); }
+        return ClauseLengths::bucket(max_len);
+    };
+    size_t pool_size = 0;
+    for (Variable& var: variables) {
+        var.pos_by_cl_len.max_len = longest(var.pos_occ);
+        var.neg_by_cl_len.max_len = longest(var.neg_occ);
+        pool_size += var.pos_by_cl_len.max_len + var.neg_by_cl_len.max_len + 2;
+    }
+    cl_len_pool.assign(pool_size, 0);
+    int* next = cl_len_pool.data();
+    for (Variable& var: variables) {
+        for (ClauseLengths* lengths: {&var.pos_by_cl_len, &var.neg_by_cl_len}) {
+            lengths->counts = next;
+            next += lengths->max_len + 1;
+        }
+        for (CRef cr: var.pos_occ) { var.pos_by_cl_len.add(clauses[cr].size); }
+        for (CRef cr: var.neg_occ) { var.neg_by_cl_len.add(clauses[cr].size); }
+    }
+}
+
+// Map the file into memory and set up a decompressor if it starts with the magic bytes of gzip or xz.
+bool DimacsInput::open(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return false;
+    }
+    size = st.st_size;
+    if (size > 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(fd);  // The mapping stays valid after closing the file.
+
+    const unsigned char* magic = reinterpret_cast<const unsigned char*>(data);
+    if (size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        format = Format::gzip;
+        gz = z_stream();
+        if (inflateInit2(&gz, 15 + 32) != Z_OK) { return false; }  // 15 + 32: accept a gzip header
+        gz.next_in = const_cast<Bytef*>(magic);
+        gz.avail_in = size;
+    } else if (size >= 6 && memcmp(data, "\xfd" "7zXZ\0", 6) == 0) {
+        format = Format::xz;
+        xz = LZMA_STREAM_INIT;
+        if (lzma_stream_decoder(&xz, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) { return false; }
+        xz.next_in = magic;
+        xz.avail_in = size;
+    } else {
+        // A plain file is scanned in place.
+        format = Format::plain;
+        pos = data;
+        end = data + size;
+        return true;
+    }
+    buffer.resize(1 << 20);
+    pos = end = buffer.data();
+    return true;
+}
+
+// Read the input from a pipe or another file descriptor that cannot be mapped, chunk by chunk.
+void DimacsInput::open_stream(int stream_fd) {
+    format = Format::stream;
+    fd = stream_fd;
+    buffer.resize(1 << 20);
+    pos = end = buffer.data();
+}
+
+// Skip everything up to the next line that starts with "p", such as comments and the "%" lines that end some benchmark files. Return false at the end of the input.
+bool DimacsInput::next_problem() {
+    skip_whitespace();
+    while (peek() != EOF && peek() != 'p') {
+        skip_line();
+        skip_whitespace();
+    }
+    return peek() != EOF;
+}
+
+void DimacsInput::close() {
+    if (format == Format::gzip) { inflateEnd(&gz); }
+    if (format == Format::xz) { lzma_end(&xz); }
+    if (data != nullptr) { munmap(const_cast<char*>(data), size); }
+    data = nullptr;
+}
+
+// Decompress the next chunk into the buffer. Return false at the end of the input.
+bool DimacsInput::refill() {
+    if (format == Format::plain) { return false; }
+    if (format == Format::stream) {
+        ssize_t n;
+        do { n = ::read(fd, buffer.data(), buffer.size()); } while (n < 0 && errno == EINTR);
+        if (n <= 0) { return false; }
+        pos = buffer.data();
+        end = pos + n;
+        return true;
+    }
+    size_t produced = 0;
+    while (produced == 0) {
+        if (format == Format::gzip) {
+            if (gz.avail_in == 0) { return false; }
+            gz.next_out = reinterpret_cast<Bytef*>(buffer.data());
+            gz.avail_out = buffer.size();
+            int ret = inflate(&gz, Z_NO_FLUSH);
+            produced = buffer.size() - gz.avail_out;
+            if (ret == Z_STREAM_END) {
+                if (gz.avail_in > 0) { inflateReset(&gz); }  // a file of several concatenated gzip members
+            } else if (ret != Z_OK) {
+                return produced > 0 && (gz.avail_in = 0, true);
+            }
+        } else {
+            if (xz.avail_in == 0) { return false; }
+            xz.next_out = reinterpret_cast<uint8_t*>(buffer.data());
+            xz.avail_out = buffer.size();
+            lzma_ret ret = lzma_code(&xz, LZMA_FINISH);
+            produced = buffer.size() - xz.avail_out;
+            if (ret != LZMA_OK) {
+                xz.avail_in = 0;
+                if (produced == 0) { return false; }
+            }
+        }
+    }
+    pos = buffer.data();
+    end = pos + produced;
+    return true;
+}
+
+void DimacsInput::skip_whitespace() {
+    while (peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r') { ++pos; }
+}
+
+void DimacsInput::skip_line() {
+    while (peek() != EOF && peek() != '\n') { ++pos; }
+}
+
+// Read a possibly negative integer after skipping whitespace. Return false if there is none or if it does not fit into an int.
+bool DimacsInput::read_int(int& result) {
+    skip_whitespace();
+    bool negative = false;
+    if (peek() == '-') {
+        negative = true;
+        ++pos;
+    }
+    if (peek() < '0' || peek() > '9') { return false; }
+    int value = 0;
+    while (peek() >= '0' && peek() <= '9') {
+        int digit = *pos - '0';
+        if (value > (numeric_limits<int>::max() - digit) / 10) { return false; }
+        value = value*10 + digit;
+        ++pos;
+    }
+    result = negative ? -value : value;
+    return true;
+}
+
+// Parse one DIMACS problem from the input into an empty formula. Duplicate literals are removed and tautological clauses are skipped. The input is read up to the last clause of the problem, so that another problem can follow. Return false if the input is not in the DIMACS format.
+bool parse_dimacs(DimacsInput& in, Formula& formula) {
+    // Skip the lines that start with "c".
+    in.skip_whitespace();
+    while (in.peek() == 'c') {
+        in.skip_line();
+        in.skip_whitespace();
     }
 
     // Read the line that starts with "p" and get the number of variables as well as the number of clauses.
-    if (s != "p") {
+    int num_vars;
+    int num_clauses;
+    if (in.peek() != 'p') { return false; }
+    ++in.pos;
+    in.skip_whitespace();
+    while (in.peek() >= 'a' && in.peek() <= 'z') { ++in.pos; }  // the format "cnf"
+    if (!in.read_int(num_vars) || !in.read_int(num_clauses) || num_vars < 0) { return false; }
+
+    formula.num_vars = num_vars;
+
+    // stamp[v] is i or -i if variable v occurs positively or negatively in the i-th clause, which detects duplicate literals and tautologies without sorting.
+    vector<int> stamp(num_vars+1, 0);
+    vector<int> lits;
+    for (int i = 1; i <= num_clauses; ++i) {
+        in.skip_whitespace();
+        // Also allow comments between the clauses and stop at the "%" that ends some benchmark files.
+        if (in.peek() == 'c') {
+            in.skip_line();
+            --i;
+            continue;
+        }
+        if (in.peek() == '%' || in.peek() == EOF) { break; }
+
+        lits.clear();
+        bool tautology = false;
+        int lit;
+        while (true) {
+            if (!in.read_int(lit) || abs(lit) > num_vars) { return false; }
+            if (lit == 0) { break; }
+            int var = abs(lit);
+            int lit_stamp = (lit > 0) ? i : -i;
+            if (stamp[var] == lit_stamp) { continue; }  // duplicate literal
+            if (stamp[var] == -lit_stamp) { tautology = true; }
+            stamp[var] = lit_stamp;
+            lits.push_back(lit);
+        }
+
+        // Only process non-tautological clauses.
+        if (tautology) { continue; }
+        if (lits.empty()) {
+            formula.empty_clause = true;
+            continue;
+        }
+        formula.clauses.alloc(lits, false);
+    }
+    return true;
+}
+
+// Parse a DIMACS file, which may be compressed with gzip or xz. Return false if the formula contains an empty clause.
+bool fromFile(string path, Formula& formula) {
+    DimacsInput in;
+    if (!in.open(path)) {
+        cout << "Cannot read " << path << "\n";
+        exit(1);
+    }
+    if (!parse_dimacs(in, formula)) {
         cout << "The format of the file is wrong.\n";
         exit(1);
-    } else {
-        string cnf;
-        int num_vars;
-        int num_clauses;
-        file >> cnf >> num_vars >> num_clauses;
-
-        // Fill the vector of variables.
-        variables.push_back(Variable());  // to allow indexing of variables to start from 1
-        for (int i = 1; i < num_vars+1; ++i) {
-            variables.push_back(Variable());
-        }
-
-        // Fill the deque of clauses.
-        for (int i = 0; i < num_clauses; ++i) {
-            set<int> lits_set;  // removes duplicate literals; for detecting tautological clause
-            int lit;
-            file >> lit;
-            while (lit != 0) {
-                lits_set.insert(lit);
-                file >> lit;
-            }
-            
-            // Only process non-tautological clauses.
-            bool tautology = false;
-            for (int lit: lits_set) {
-                if (lits_set.count(-lit) > 0) {
-                    tautology = true;
-                    break;
+    }
+    in.close();
+    return !formula.empty_clause;
+}
+
+// Empty the formula, keeping the memory of its clause arena for the next one.
+void Formula::clear() {
+    num_vars = 0;
+    clauses.memory.clear();
+    clauses.wasted = 0;
+    empty_clause = false;
+    reconstruction.clear();
+}
+
+// Undo the preprocessing on a model of the simplified formula: walk the removed clauses backwards and make the first literal of every falsified one true.
+void Formula::extend_model(vector<Value>& model) const {
+    size_t i = reconstruction.size();
+    while (i > 0) {
+        int len = reconstruction[--i];
+        i -= len;
+        const int* lits = &reconstruction[i];
+        bool satisfied = any_of(lits, lits+len, [&model](int lit) { return model[abs(lit)] == ((lit > 0) ? Value::t : Value::f); });
+        if (!satisfied) { model[abs(lits[0])] = (lits[0] > 0) ? Value::t : Value::f; }
+    }
+}
+
+// Create the proof file and start the writer thread.
+bool Proof::open(const string& path) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { return false; }
+    filling.reserve(buffer_size + 1024);
+    writing.reserve(buffer_size + 1024);
+    writer = thread(&Proof::write_loop, this);
+    return true;
+}
+
+// Append the addition ('a') or deletion ('d') of a clause. Every literal is mapped to 2*var + sign and written in 7-bit groups, the lowest group first, with the high bit set on all but the last group.
+void Proof::record(uint8_t kind, const int* begin, const int* end) {
+    filling.push_back(kind);
+    for (const int* lit = begin; lit != end; ++lit) {
+        uint32_t code = 2*abs(*lit) + (*lit < 0);
+        while (code > 127) {
+            filling.push_back(0x80 | (code & 127));
+            code >>= 7;
+        }
+        filling.push_back(code);
+    }
+    filling.push_back(0);
+    if (filling.size() >= buffer_size) { flush(); }
+}
+
+// Hand the filled buffer to the writer thread, after waiting for it to finish the previous one.
+void Proof::flush() {
+    unique_lock<mutex> lock(m);
+    cv.wait(lock, [this] { return writing.empty(); });
+    swap(filling, writing);
+    cv.notify_all();
+}
+
+// The writer thread: write every buffer that is handed over until the proof is closed.
+void Proof::write_loop() {
+    unique_lock<mutex> lock(m);
+    while (true) {
+        cv.wait(lock, [this] { return !writing.empty() || closing; });
+        if (writing.empty()) { return; }
+        lock.unlock();
+        bool ok = true;
+        for (size_t done = 0; done < writing.size() && ok; ) {
+            ssize_t n = ::write(fd, writing.data() + done, writing.size() - done);
+            if (n > 0) { done += n; }
+            else if (n < 0 && errno != EINTR) { ok = false; }
+        }
+        lock.lock();
+        if (!ok) { failed = true; }
+        writing.clear();
+        cv.notify_all();
+    }
+}
+
+// Write the rest of the proof and close the file. Return false if any write failed.
+bool Proof::close() {
+    if (fd < 0) { return !failed; }
+    if (!filling.empty()) { flush(); }
+    {
+        lock_guard<mutex> lock(m);
+        closing = true;
+    }
+    cv.notify_all();
+    writer.join();
+    ::close(fd);
+    fd = -1;
+    return !failed;
+}
+
+Preprocessor::Preprocessor(Formula& formula) : formula(formula) {
+    int n = formula.num_vars;
+    occ.resize(2*n+2);
+    values.assign(n+1, Value::unset);
+    eliminated.assign(n+1, false);
+    marked.assign(2*n+2, false);
+    ClauseArena& arena = formula.clauses;
+    for (CRef cr = 0; cr < arena.memory.size(); cr += ClauseArena::words(arena[cr])) {
+        Clause& cl = arena[cr];
+        add_clause(vector<int>(cl.begin(), cl.end()));
+    }
+    probe_budget = 10 * (long long)arena.memory.size();
+    // The queue is a stack, so the short clauses, which subsume the most, come first.
+    sort(queue.begin(), queue.end(), [this](int i, int j) { return clauses[i].size() > clauses[j].size(); });
+}
+
+// Return the value of a literal under the current assignment.
+Value Preprocessor::lit_value(int lit) {
+    Value v = values[abs(lit)];
+    if (v == Value::unset || lit > 0) { return v; }
+    return (v == Value::t) ? Value::f : Value::t;
+}
+
+void Preprocessor::add_clause(const vector<int>& lits) {
+    if (lits.empty()) {
+        unsat = true;
+        return;
+    }
+    int i = clauses.size();
+    clauses.push_back(lits);
+    removed.push_back(false);
+    queued.push_back(true);
+    queue.push_back(i);
+    for (int lit: lits) { occ[lit_index(lit)].push_back(i); }
+    if (lits.size() == 1) { units.push_back(lits[0]); }
+}
+
+// Return the clauses that contain a literal after dropping the removed ones from its occurrence list.
+vector<int>& Preprocessor::occurrences(int lit) {
+    vector<int>& list = occ[lit_index(lit)];
+    list.erase(remove_if(list.begin(), list.end(), [this](int i) { return removed[i]; }), list.end());
+    return list;
+}
+
+// Remove a literal from a clause, which may make the clause unit or empty.
+void Preprocessor::strengthen(int i, int lit) {
+    vector<int>& cl = clauses[i];
+    vector<int> original;
+    if (proof != nullptr) { original = cl; }
+    cl.erase(find(cl.begin(), cl.end(), lit));
+    if (proof != nullptr) {
+        proof->add(cl);
+        proof->remove(original);
+    }
+    vector<int>& list = occ[lit_index(lit)];
+    list.erase(find(list.begin(), list.end(), i));
+    if (cl.empty()) { unsat = true; }
+    if (cl.size() == 1) { units.push_back(cl[0]); }
+    if (!queued[i]) {
+        queued[i] = true;
+        queue.push_back(i);
+    }
+}
+
+// Push a clause onto the reconstruction stack, with the literal that has to be made true if the model falsifies the clause first.
+void Preprocessor::save(const vector<int>& lits, int witness) {
+    formula.reconstruction.push_back(witness);
+    for (int lit: lits) {
+        if (lit != witness) { formula.reconstruction.push_back(lit); }
+    }
+    formula.reconstruction.push_back(lits.size());
+}
+
+// Fix the literals of the unit clauses on the top level: remove the clauses they satisfy and their negations from the other clauses. Return false if this derives the empty clause.
+bool Preprocessor::propagate() {
+    while (!units.empty() && !unsat) {
+        int lit = units.back();
+        units.pop_back();
+        if (lit_value(lit) == Value::t) { continue; }
+        if (lit_value(lit) == Value::f) {
+            unsat = true;
+            break;
+        }
+        values[abs(lit)] = (lit > 0) ? Value::t : Value::f;
+        save({lit}, lit);
+        // The clauses are strengthened before the satisfied ones are removed, so that the unit clause is still in the proof when they are derived.
+        vector<int> falsified = occurrences(-lit);  // a copy, because strengthen erases from the list
+        for (int i: falsified) { strengthen(i, -lit); }
+        for (int i: occurrences(lit)) {
+            removed[i] = true;
+            if (proof != nullptr) { proof->remove(clauses[i]); }
+        }
+    }
+    return !unsat;
+}
+
+// Backward subsumption and self-subsuming strengthening with the queued clauses. A clause C can only subsume or strengthen a clause that contains the literal of C's rarest variable or its negation.
+void Preprocessor::subsume() {
+    while (!queue.empty() && !unsat) {
+        int i = queue.back();
+        queue.pop_back();
+        queued[i] = false;
+        if (removed[i]) { continue; }
+        const vector<int>& cl = clauses[i];
+        int best = cl[0];
+        for (int lit: cl) {
+            if (occ[lit_index(lit)].size() + occ[lit_index(-lit)].size() < occ[lit_index(best)].size() + occ[lit_index(-best)].size()) { best = lit; }
+        }
+        for (int lit: cl) { marked[lit_index(lit)] = true; }
+        vector<int> candidates = occurrences(best);
+        vector<int>& opposite = occurrences(-best);
+        candidates.insert(candidates.end(), opposite.begin(), opposite.end());
+        for (int j: candidates) {
+            if (j == i || removed[j] || clauses[j].size() < cl.size()) { continue; }
+            size_t matched = 0;
+            int flipped = 0;  // the only literal of clauses[j] whose negation is in cl
+            bool fail = false;
+            for (int lit: clauses[j]) {
+                if (marked[lit_index(lit)]) { ++matched; }
+                else if (marked[lit_index(-lit)]) {
+                    if (flipped != 0) {
+                        fail = true;
+                        break;
+                    }
+                    flipped = lit;
                 }
             }
-            if (tautology) { continue; }
-            vector<int> lits;
-            for (int lit: lits_set) { lits.push_back(lit); }
-            clauses.push_back(Clause(lits, lits.size()));
-
-            Clause* cl = &clauses.back();
-            if (cl->active == 0) {
-                cout << "s UNSATISFIABLE\n";
-                exit(0);
+            if (fail) { continue; }
+            if (flipped == 0 && matched == cl.size()) {
+                removed[j] = true;
+                if (proof != nullptr) { proof->remove(clauses[j]); }
+            } else if (flipped != 0 && matched == cl.size()-1) {
+                // Resolving on flipped gives a subset of clauses[j], therefore flipped can be dropped.
+                strengthen(j, flipped);
             }
-            if (cl->active == 1) { unit_clauses.push_back(cl); }
-
-            for (int lit: lits) {
-                if (lit > 0) {
-                    variables[lit].pos_occ.push_back(cl);
-                    variables[lit].active_pos_occ += 1;
-                    variables[lit].pos_by_cl_len[cl->active] += 1;
-                    variables[lit].jw_pos += pow(2, -cl->active);
-                } else {
-                    variables[-lit].neg_occ.push_back(cl);
-                    variables[-lit].active_neg_occ += 1;
-                    variables[-lit].neg_by_cl_len[cl->active] += 1;
-                    variables[-lit].jw_neg += pow(2, -cl->active);
+        }
+        for (int lit: cl) { marked[lit_index(lit)] = false; }
+    }
+}
+
+// Alternate unit propagation and subsumption until neither changes the formula. Return false if the formula is unsatisfiable.
+bool Preprocessor::simplify() {
+    while (propagate() && !queue.empty()) { subsume(); }
+    return !unsat;
+}
+
+// Assign a literal temporarily and propagate it. Return false if this leads to a conflict, i.e. the literal failed.
+bool Preprocessor::probe_lit(int probed) {
+    vector<int> trail{probed};
+    values[abs(probed)] = (probed > 0) ? Value::t : Value::f;
+    bool conflict = false;
+    for (size_t k = 0; k < trail.size() && !conflict; ++k) {
+        for (int i: occ[lit_index(-trail[k])]) {
+            if (removed[i]) { continue; }
+            --probe_budget;
+            int unassigned = 0;
+            int last = 0;
+            bool satisfied = false;
+            for (int lit: clauses[i]) {
+                Value v = lit_value(lit);
+                if (v == Value::t) {
+                    satisfied = true;
+                    break;
                 }
+                if (v == Value::unset) {
+                    ++unassigned;
+                    last = lit;
+                }
+            }
+            if (satisfied || unassigned > 1) { continue; }
+            if (unassigned == 0) {
+                conflict = true;
+                break;
             }
+            values[abs(last)] = (last > 0) ? Value::t : Value::f;
+            trail.push_back(last);
         }
+    }
+    for (int lit: trail) { values[abs(lit)] = Value::unset; }
+    return !conflict;
+}
 
-        for (int i = 1; i < num_vars+1; ++i) {
-            if (variables[i].pos_occ.empty() || variables[i].neg_occ.empty()){
-                pure_lits.push_back(&variables[i]);
+// Failed literal probing: a literal whose assignment propagates to a conflict is fixed to false. Only literals whose negation occurs in a binary clause are probed, since all others propagate nothing.
+void Preprocessor::probe() {
+    for (int var = 1; var <= formula.num_vars && probe_budget > 0; ++var) {
+        for (int lit: {var, -var}) {
+            if (values[var] != Value::unset) { break; }
+            const vector<int>& binaries = occurrences(-lit);
+            if (none_of(binaries.begin(), binaries.end(), [this](int i) { return clauses[i].size() == 2; })) { continue; }
+            if (!probe_lit(lit)) {
+                if (proof != nullptr) { proof->add({-lit}); }
+                units.push_back(-lit);
+                if (!simplify()) { return; }
             }
         }
-        assert(variables.size() == num_vars+1);
     }
 }
 
-// Unit propagation
-void unit_prop() {
-    while (!unit_clauses.empty()) {
-        Clause* cl = unit_clauses.back();
-        unit_clauses.pop_back();
-        for (int lit: cl->lits) {
-            Variable* var = &variables[abs(lit)];
-            if (var->value == Value::unset) {  // A clause does not keep track of which literals are unassigned.
-                if (lit > 0) {
-                    var->set(Value::t, Mark::forced);
-                } else {
-                    var->set(Value::f, Mark::forced);
-                }
-                break;
+// Compute the resolvent of two clauses on a variable. Return false if it is a tautology.
+bool Preprocessor::resolve(int i, int j, int var, vector<int>& resolvent) {
+    resolvent.clear();
+    for (int lit: clauses[i]) {
+        if (abs(lit) == var) { continue; }
+        marked[lit_index(lit)] = true;
+        resolvent.push_back(lit);
+    }
+    bool tautology = false;
+    for (int lit: clauses[j]) {
+        if (abs(lit) == var || marked[lit_index(lit)]) { continue; }
+        if (marked[lit_index(-lit)]) {
+            tautology = true;
+            break;
+        }
+        resolvent.push_back(lit);
+    }
+    for (int lit: clauses[i]) { marked[lit_index(lit)] = false; }
+    return !tautology;
+}
+
+// Bounded variable elimination: replace the clauses of a variable by all their non-tautological resolvents if there are not more of them. Variables with few occurrences are tried first.
+void Preprocessor::eliminate() {
+    vector<int> order;
+    for (int var = 1; var <= formula.num_vars; ++var) { order.push_back(var); }
+    sort(order.begin(), order.end(), [this](int v1, int v2) { return occ[lit_index(v1)].size() + occ[lit_index(-v1)].size() < occ[lit_index(v2)].size() + occ[lit_index(-v2)].size(); });
+    vector<vector<int>> resolvents;
+    vector<int> resolvent;
+    for (int var: order) {
+        if (values[var] != Value::unset) { continue; }
+        vector<int> pos = occurrences(var);
+        vector<int> neg = occurrences(-var);
+        if (pos.empty() && neg.empty()) { continue; }
+        if (pos.size() > max_occ && neg.size() > max_occ) { continue; }
+        resolvents.clear();
+        bool bounded = true;
+        for (size_t p = 0; p < pos.size() && bounded; ++p) {
+            for (size_t q = 0; q < neg.size() && bounded; ++q) {
+                if (!resolve(pos[p], neg[q], var, resolvent)) { continue; }
+                bounded = resolvent.size() <= max_resolvent_len && resolvents.size() < pos.size() + neg.size();
+                resolvents.push_back(resolvent);
             }
         }
+        if (!bounded) { continue; }
+
+        // A model of the resolvents is extended by making the variable false, unless that falsifies a clause of the smaller side.
+        eliminated[var] = true;
+        int lit = (pos.size() <= neg.size()) ? var : -var;
+        for (int i: (lit > 0) ? pos : neg) { save(clauses[i], lit); }
+        save({-lit}, -lit);
+        // The resolvents follow from the clauses of the variable, which are then deleted.
+        if (proof != nullptr) {
+            for (const vector<int>& res: resolvents) { proof->add(res); }
+            for (int i: pos) { proof->remove(clauses[i]); }
+            for (int i: neg) { proof->remove(clauses[i]); }
+        }
+        for (int i: pos) { removed[i] = true; }
+        for (int i: neg) { removed[i] = true; }
+        for (const vector<int>& res: resolvents) { add_clause(res); }
+        if (!simplify()) { return; }
     }
 }
 
-// Pure literal elimination
-void pure_lit(){
-    if (use_pure_lit) {
-        for (Variable* var: pure_lits){
-            if (var->value == Value::unset){
-                Value v = var->active_pos_occ == 0 ? Value::f : Value::t;
-                var->set(v, Mark::forced);
+// The number of variables that occur in the remaining clauses.
+int Preprocessor::count_vars() {
+    int count = 0;
+    for (int var = 1; var <= formula.num_vars; ++var) {
+        if (!occurrences(var).empty() || !occurrences(-var).empty()) { ++count; }
+    }
+    return count;
+}
+
+int Preprocessor::count_clauses() {
+    return count(removed.begin(), removed.end(), false);
+}
+
+// Run all simplifications and replace the clauses of the formula by the remaining ones. Return false if the formula is unsatisfiable.
+bool Preprocessor::run() {
+    if (simplify()) { probe(); }
+    if (!unsat) { eliminate(); }
+    if (unsat) {
+        formula.empty_clause = true;
+        return false;
+    }
+    ClauseArena arena;
+    for (size_t i = 0; i < clauses.size(); ++i) {
+        if (!removed[i]) { arena.alloc(clauses[i], false); }
+    }
+    formula.clauses = move(arena);
+    return true;
+}
+
+// The counters as pairs of names and values, in the order they are printed.
+template<typename F>
+void for_each_stat(const Stats& stats, F f) {
+    f("decisions", stats.decisions);
+    f("propagations", stats.propagations);
+    f("pure_literals", stats.pure_literals);
+    f("conflicts", stats.conflicts);
+    f("backtracks", stats.backtracks);
+    f("restarts", stats.restarts);
+    f("learnt_clauses", stats.learnt_clauses);
+    f("lookaheads", stats.lookaheads);
+    f("failed_literals", stats.failed_literals);
+    f("assignments", stats.assignments);
+    f("clause_visits", stats.clause_visits);
+    f("clause_visits_per_assignment", (stats.assignments > 0) ? (double)stats.clause_visits / stats.assignments : 0.0);
+    f("heap_moves", stats.heap_moves);
+    f("heap_swaps", stats.heap_swaps);
+    f("parse_time", stats.parse_time);
+    f("preprocess_time", stats.preprocess_time);
+    f("unit_prop_time", stats.unit_prop_time);
+    f("pure_lit_time", stats.pure_lit_time);
+    f("backtrack_time", stats.backtrack_time);
+    f("solve_time", stats.solve_time);
+}
+
+// Add the counters of another solver, e.g. another worker of the cube-and-conquer mode.
+Stats& Stats::operator+=(const Stats& other) {
+    decisions += other.decisions;
+    propagations += other.propagations;
+    pure_literals += other.pure_literals;
+    conflicts += other.conflicts;
+    backtracks += other.backtracks;
+    restarts += other.restarts;
+    learnt_clauses += other.learnt_clauses;
+    lookaheads += other.lookaheads;
+    failed_literals += other.failed_literals;
+    assignments += other.assignments;
+    clause_visits += other.clause_visits;
+    heap_moves += other.heap_moves;
+    heap_swaps += other.heap_swaps;
+    unit_prop_time += other.unit_prop_time;
+    pure_lit_time += other.pure_lit_time;
+    backtrack_time += other.backtrack_time;
+    solve_time += other.solve_time;
+    return *this;
+}
+
+// Print one line per counter, which starts with "c " to be a comment in the DIMACS output format.
+void Stats::print(ostream& out, const string& prefix) const {
+    for_each_stat(*this, [&](const char* name, auto value) { out << prefix << name << ": " << value << "\n"; });
+}
+
+// Write the counters as a JSON object. Return false if the file cannot be written.
+bool Stats::write_json(const string& path) const {
+    ofstream out(path);
+    if (!out) { return false; }
+    out << "{";
+    const char* separator = "\n";
+    for_each_stat(*this, [&](const char* name, auto value) {
+        out << separator << "  \"" << name << "\": " << value;
+        separator = ",\n";
+    });
+    out << "\n}\n";
+    return bool(out);
+}
+
+// The flags that select a configuration on the command line.
+string Config::name() const {
+    const char* heu_flags[] = {"", "-slis", "-slcs", "-dlis", "-dlcs", "-bc", "-mom", "-boehm", "-jw", "-la"};
+    string name = heu_flags[static_cast<int>(heu)];
+    if (use_pure_lit) { name += " -p"; }
+    if (use_cdcl) { name += " -cdcl"; }
+    else if (use_watched) { name += " -wl"; }
+    if (restart == Restart::luby) { name += " -luby"; }
+    if (restart == Restart::glucose) { name += " -glucose"; }
+    if (name.empty()) { return "no heuristic"; }
+    return (name[0] == ' ') ? name.substr(1) : name;
+}
+
+Solver::Solver(const Formula& formula, const Config& config, const atomic<bool>* stop)
+    : heu(config.heu), use_pure_lit(config.use_pure_lit), use_watched(config.use_watched || config.use_cdcl), use_cdcl(config.use_cdcl), restart(config.restart), stop(stop), mem_limit(config.mem_limit), seed(config.seed), rng(config.seed) {
+    select_counting_code();
+    unassigned_vars.heu = heu;
+    unassigned_vars.stats = &stats;
+    load(formula);
+}
+
+// Reset a variable to its state before the search, keeping the memory of its clause lists.
+void Variable::clear() {
+    Variable fresh;
+    swap(fresh.pos_occ, pos_occ);
+    swap(fresh.neg_occ, neg_occ);
+    swap(fresh.pos_watch, pos_watch);
+    swap(fresh.neg_watch, neg_watch);
+    for (vector<CRef>* list: {&fresh.pos_occ, &fresh.neg_occ, &fresh.pos_watch, &fresh.neg_watch}) { list->clear(); }
+    *this = move(fresh);
+}
+
+// Copy the clauses of a formula into the solver's own arena and set up the occurrence lists, watches, scores and the heap. Everything the solver learned about the previous formula is dropped, but its memory is reused, so one solver can solve many small formulas one after another.
+void Solver::load(const Formula& formula) {
+    clauses.memory.assign(formula.clauses.memory.begin(), formula.clauses.memory.end());
+    clauses.wasted = formula.clauses.wasted;
+    original_words = clauses.memory.size();
+    for (Variable& var: variables) { var.clear(); }
+    variables.resize(formula.num_vars+1);  // to allow indexing of variables to start from 1
+    lit_values.assign(2*formula.num_vars + 1 + gather_padding, uint8_t(Value::unset));
+    assignments.clear();
+    level_begin.clear();
+    root_level = 0;
+    unit_clauses.clear();
+    conflict_clause = no_clause;
+    unassigned_vars.heap.resize(1);
+    unassigned_vars.dirty.clear();
+    bump_increment = 1;
+    conflicts_since_restart = 0;
+    restarts = 0;
+    recent_lbds.clear();
+    next_lbd = 0;
+    recent_lbd_sum = 0;
+    total_lbd_sum = 0;
+    conflicts = 0;
+    learnt_clauses.clear();
+    learnt_units.clear();
+    inconsistent = false;
+    failed.clear();
+    stats = Stats();
+    last_progress = chrono::steady_clock::now();
+    reduce_interval = 2000;
+    conflicts_until_reduce = reduce_interval;
+    rng = Random(seed);
+
+    for (CRef cr = 0; cr < clauses.memory.size(); cr += ClauseArena::words(clauses[cr])) {
+        Clause& cl = clauses[cr];
+        if (cl.size == 1) { unit_clauses.push_back(cr); }
+        else if (use_watched) {
+            watch_list(cl[0]).push_back(cr);
+            watch_list(cl[1]).push_back(cr);
+        }
+
+        // Only the counting code visits the occurrences of a literal. With watched literals, their numbers are enough.
+        for (int lit: cl) {
+            if (lit > 0) {
+                if (!use_watched) { variables[lit].pos_occ.push_back(cr); }
+                variables[lit].pos_count += 1;
+                variables[lit].active_pos_occ += 1;
+                variables[lit].jw_pos += jw_weight(cl.size);
+            } else {
+                if (!use_watched) { variables[-lit].neg_occ.push_back(cr); }
+                variables[-lit].neg_count += 1;
+                variables[-lit].active_neg_occ += 1;
+                variables[-lit].jw_neg += jw_weight(cl.size);
             }
         }
-        pure_lits.clear();
+    }
+    if (heu == Heuristic::mom || heu == Heuristic::boehm) { init_cl_len_counts(); }
+    // Fill the unassigned_vars heap. Originally all variables are unassigned.
+    for (int i = 1; i < variables.size(); ++i) {
+        if (heu == Heuristic::none) {
+            variables[i].priority = rng.priority();  // Pick variables randomly.
+        }
+        variables[i].update_priority(heu);
+        unassigned_vars.insert(&variables[i]);
+    }
+}
+
+// Unit propagation, which stops at the first conflict.
+void Solver::unit_prop() {
+    STAT(ScopedTimer timer(stats.unit_prop_time));
+    while (!unit_clauses.empty() && conflict_clause == no_clause) {
+        CRef cr = unit_clauses.back();
+        unit_clauses.pop_back();
+        Clause& cl = clauses[cr];
+        // Clauses of length one are not watched, therefore a conflict between them is only detected here.
+        if (use_watched && cl.size == 1 && lit_value(cl[0]) == Value::f) {
+            conflict_clause = cr;
+            break;
+        }
+        // A clause does not keep track of which literals are unassigned. All its other literals are false, so the first one that is not false is the one to propagate, unless it has become true in the meantime.
+        int k = scan_not_false(cl, 0);
+        if (k < cl.size && lit_value(cl[k]) == Value::unset) {
+            STAT(++stats.propagations);
+            set(&variables[abs(cl[k])], (cl[k] > 0) ? Value::t : Value::f, Mark::forced, cr);
+        }
+    }
+}
+
+// Pure literal elimination: assign every unassigned variable whose literal of one polarity occurs in no active clause. Instead of counting the active occurrences on every assignment and unassignment, the variables are scanned in one pass, which stops looking at the clauses of a literal at the first active one. The pass only runs up to decision level pure_lit_depth, where a pure literal removes the largest subtree, and it is repeated while it assigns literals, since they can make others pure.
+void Solver::pure_lit() {
+    if (!use_pure_lit || conflict_clause != no_clause || (int)level_begin.size() > pure_lit_depth) { return; }
+    STAT(ScopedTimer timer(stats.pure_lit_time));
+    auto occurs_active = [this](const vector<CRef>& occ) {
+        return any_of(occ.begin(), occ.end(), [this](CRef cr) { return clauses[cr].sat_var == 0; });
+    };
+    bool assigned = true;
+    while (assigned) {
+        assigned = false;
+        for (size_t i = 1; i < variables.size(); ++i) {
+            Variable* var = &variables[i];
+            if (var->value != Value::unset) { continue; }
+            bool pos_active = occurs_active(var->pos_occ);
+            if (pos_active && occurs_active(var->neg_occ)) { continue; }
+            // Setting a pure literal only satisfies clauses, so it cannot lead to a unit clause or a conflict.
+            STAT(++stats.pure_literals);
+            set(var, pos_active ? Value::t : Value::f, Mark::forced);
+            assigned = true;
+        }
+    }
+}
+
+// Increase the backtrack count of a variable. When the counts get too large for a double, all of them and the cached priorities are scaled down by the same factor, which keeps the heap in order.
+void Solver::bump(Variable* var) {
+    var->backtrack_count += bump_increment;
+    if (var->backtrack_count > 1e100) {
+        for (Variable& v: variables) {
+            v.backtrack_count *= 1e-100;
+            if (heu == Heuristic::backtrack_count) { v.priority *= 1e-100; }
+        }
+        bump_increment *= 1e-100;
     }
 }
 
-// Backtracking
-void backtrack() {
+// Let the backtrack counts lose half of their weight every 200 conflicts. Instead of dividing all counts, the later bumps grow by the inverse factor.
+void Solver::decay_backtrack_counts() {
+    if (heu == Heuristic::backtrack_count) { bump_increment *= bump_growth; }
+}
+
+// The i-th element of the Luby sequence 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ..., counted from 0.
+int luby(int i) {
+    int size = 1;  // the length of the smallest complete subsequence that contains the i-th element
+    int exponent = 0;
+    while (size < i+1) {
+        ++exponent;
+        size = 2*size + 1;
+    }
+    while (size-1 != i) {
+        size = (size-1) / 2;
+        --exponent;
+        i %= size;
+    }
+    return 1 << exponent;
+}
+
+// Count a conflict for the restart policy, together with the LBD of the clause learned from it.
+void Solver::record_conflict(int lbd) {
+    ++conflicts_since_restart;
+    if (restart != Restart::glucose) { return; }
+    ++conflicts;
+    total_lbd_sum += lbd;
+    recent_lbd_sum += lbd;
+    if (recent_lbds.size() < lbd_window) {
+        recent_lbds.push_back(lbd);
+    } else {
+        recent_lbd_sum -= recent_lbds[next_lbd];
+        recent_lbds[next_lbd] = lbd;
+        next_lbd = (next_lbd + 1) % lbd_window;
+    }
+}
+
+// Whether the search should start again from the root level before the next decision.
+bool Solver::restart_due() {
+    if ((int)level_begin.size() <= root_level) { return false; }
+    switch (restart) {
+        case Restart::none:
+            return false;
+        case Restart::luby:
+            return conflicts_since_restart >= luby(restarts) * luby_unit;
+        case Restart::glucose:
+            // The recent learned clauses are of low quality: their average LBD, scaled by 0.8, is above the average of all learned clauses.
+            return recent_lbds.size() == lbd_window && 0.8 * recent_lbd_sum * conflicts > (double)total_lbd_sum * lbd_window;
+    }
+    return false;
+}
+
+// Give every variable a new random priority, so that the default heuristic branches in a different random order after a restart.
+void Solver::shuffle_priorities() {
+    for (size_t i = 1; i < variables.size(); ++i) { variables[i].priority = rng.priority(); }
+    unassigned_vars.rebuild();
+}
+
+// Undo all decisions above the root level. Learned clauses, backtrack counts and saved phases are kept.
+void Solver::restart_search() {
+    backtrack_to(root_level);
+    ++restarts;
+    STAT(++stats.restarts);
+    if (heu == Heuristic::none) { shuffle_priorities(); }
+    conflicts_since_restart = 0;
+    recent_lbds.clear();
+    next_lbd = 0;
+    recent_lbd_sum = 0;
+}
+
+// Backtracking: undo all assignments of the current decision level and flip its branching literal, which then counts as forced on the previous decision level. Return false if there is no decision level left above the root, i.e. the formula is unsatisfiable under the assumptions. The conflict clause is then kept for analyze_final.
+bool Solver::backtrack() {
+    if ((int)level_begin.size() <= root_level) { return false; }
+    STAT(ScopedTimer timer(stats.backtrack_time));
+    STAT(++stats.backtracks);
     unit_clauses.clear();
-    pure_lits.clear();
-    while (!assignments.empty()) {
+    conflict_clause = no_clause;
+    decay_backtrack_counts();
+    record_conflict(0);  // Without clause learning there is no LBD, which only the Glucose restarts need.
+
+    // The clause that rules out the current decisions follows by unit propagation, and it implies the flipped literal on the previous level.
+    if (proof != nullptr) { log_with_decisions({}); }
+    size_t begin = level_begin.back();
+    level_begin.pop_back();
+    while (assignments.size() > begin+1) {
         Variable* var = assignments.back().first;
-        Mark mark = assignments.back().second;
         assignments.pop_back();
-        ++var->backtrack_count;  // The priority of a variable increases if it is on the backtracking path.
-        if (mark == Mark::forced) {
-            var->unset();
-        }
-        else {
-            Value old_value = var->value;
-            var->unset();
-            var->set((old_value == Value::t) ? Value::f : Value::t, Mark::forced);
-            return;
+        bump(var);  // The priority of a variable increases if it is on the backtracking path.
+        unset(var);
+    }
+    Variable* var = assignments.back().first;
+    assert(assignments.back().second == Mark::branching);
+    assignments.pop_back();
+    bump(var);
+    Value old_value = var->value;
+    unset(var);
+    set(var, (old_value == Value::t) ? Value::f : Value::t, Mark::forced);
+    return true;
+}
+
+// Return the literal that is true under the variable's current value.
+int Solver::true_lit(Variable* var) {
+    int var_ind = index_of(var);
+    return (var->value == Value::t) ? var_ind : -var_ind;
+}
+
+// Move all clauses that are not deleted to a new arena and update all references to them.
+void Solver::garbage_collect() {
+    ClauseArena to;
+    to.memory.reserve(clauses.memory.size() - clauses.wasted);
+    // The header of a moved clause stores its new reference in sat_var, which is not used with watched literals.
+    for (CRef cr = 0; cr < clauses.memory.size(); cr += ClauseArena::words(clauses[cr])) {
+        Clause& cl = clauses[cr];
+        if (!cl.deleted) {
+            CRef new_cr = to.memory.size();
+            to.memory.insert(to.memory.end(), &clauses.memory[cr], &clauses.memory[cr] + ClauseArena::words(cl));
+            cl.sat_var = new_cr;
+        }
+    }
+    auto relocate = [this](vector<CRef>& crs) {
+        for (CRef& cr: crs) { cr = clauses[cr].sat_var; }
+    };
+    for (Variable& var: variables) {
+        relocate(var.pos_occ);
+        relocate(var.neg_occ);
+        relocate(var.pos_watch);
+        relocate(var.neg_watch);
+        if (var.value != Value::unset && var.reason != no_clause) { var.reason = clauses[var.reason].sat_var; }
+    }
+    relocate(learnt_clauses);
+    relocate(learnt_units);
+    clauses = move(to);
+}
+
+// Delete the learned clauses that are unlikely to be useful again: the clauses longer than max_learnt_len and the half with the highest LBD, except for clauses with LBD 2 or lower. Clauses that are the reason of a current assignment are kept.
+void Solver::reduce_learnt() {
+    sort(learnt_clauses.begin(), learnt_clauses.end(), [this](CRef cr1, CRef cr2) {
+        Clause& cl1 = clauses[cr1];
+        Clause& cl2 = clauses[cr2];
+        return cl1.lbd < cl2.lbd || (cl1.lbd == cl2.lbd && cl1.size < cl2.size);
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < learnt_clauses.size(); ++i) {
+        CRef cr = learnt_clauses[i];
+        Clause& cl = clauses[cr];
+        Variable* implied = &variables[abs(cl[0])];
+        bool locked = implied->value != Value::unset && implied->reason == cr;
+        bool useless = (i >= learnt_clauses.size()/2 && cl.lbd > 2) || cl.size > max_learnt_len;
+        if (!locked && useless) {
+            if (proof != nullptr) { proof->remove(cl.begin(), cl.end()); }
+            clauses.free(cr);
+        } else {
+            learnt_clauses[kept++] = cr;
+        }
+    }
+    learnt_clauses.resize(kept);
+    // Remove the deleted clauses from the watch lists.
+    auto is_deleted = [this](CRef cr) { return clauses[cr].deleted; };
+    for (Variable& var: variables) {
+        var.pos_watch.erase(remove_if(var.pos_watch.begin(), var.pos_watch.end(), is_deleted), var.pos_watch.end());
+        var.neg_watch.erase(remove_if(var.neg_watch.begin(), var.neg_watch.end(), is_deleted), var.neg_watch.end());
+    }
+    if (clauses.wasted > clauses.memory.size() / 5) { garbage_collect(); }
+}
+
+// Whether the learned clauses take more than a quarter of the memory limit. Then they are reduced before the next scheduled reduction, but at most every 100 conflicts, since the clauses with a low LBD are always kept.
+bool Solver::memory_short() {
+    if (mem_limit == 0 || reduce_interval - conflicts_until_reduce < 100) { return false; }
+    size_t learnt_words = clauses.memory.size() - clauses.wasted - original_words;
+    return learnt_words * sizeof(uint32_t) > mem_limit / 4;
+}
+
+// Store a learned clause and watch its first two literals.
+CRef Solver::add_learnt(const vector<int>& lits, int lbd) {
+    STAT(++stats.learnt_clauses);
+    if (proof != nullptr) { proof->add(lits); }
+    CRef cr = clauses.alloc(lits, true);
+    clauses[cr].lbd = lbd;
+    if (lits.size() > 1) {
+        learnt_clauses.push_back(cr);
+        watch_list(lits[0]).push_back(cr);
+        watch_list(lits[1]).push_back(cr);
+    } else {
+        learnt_units.push_back(cr);
+    }
+    return cr;
+}
+
+// Undo all assignments above a decision level.
+void Solver::backtrack_to(int level) {
+    while ((int)level_begin.size() > level) {
+        STAT(++stats.backtracks);
+        size_t begin = level_begin.back();
+        level_begin.pop_back();
+        while (assignments.size() > begin) {
+            Variable* var = assignments.back().first;
+            assignments.pop_back();
+            unset(var);
+        }
+    }
+}
+
+// Conflict-driven clause learning: derive the first-UIP clause from conflict_clause by resolving with the reasons of the assignments on the current decision level, backjump to the second highest decision level in the learned clause and assert its UIP literal there. Return false if the conflict does not depend on any decision above the root, i.e. the formula is unsatisfiable under the assumptions. The conflict clause is then kept for analyze_final.
+bool Solver::backjump() {
+    if ((int)level_begin.size() <= root_level) { return false; }
+    STAT(ScopedTimer timer(stats.backtrack_time));
+    unit_clauses.clear();
+    decay_backtrack_counts();
+
+    int current_level = level_begin.size();
+    vector<int> learnt{0};  // learnt[0] is reserved for the UIP literal.
+    int open_lits = 0;  // the number of literals on the current decision level that have not been resolved yet
+    size_t index = assignments.size();
+    CRef cr = conflict_clause;
+    Variable* resolved_var = nullptr;
+    do {
+        for (int lit: clauses[cr]) {
+            Variable* var = &variables[abs(lit)];
+            if (var == resolved_var || var->seen || var->level == 0) { continue; }
+            var->seen = true;
+            bump(var);  // The priority of a variable increases if it takes part in a conflict.
+            if (var->level == current_level) { ++open_lits; }
+            else { learnt.push_back(lit); }
+        }
+        // Resolve on the most recently assigned variable that takes part in the conflict.
+        while (!assignments[--index].first->seen) {}
+        resolved_var = assignments[index].first;
+        resolved_var->seen = false;
+        cr = resolved_var->reason;
+        --open_lits;
+    } while (open_lits > 0);
+    learnt[0] = -true_lit(resolved_var);
+    conflict_clause = no_clause;
+
+    // Find the asserting level and move a literal of that level to learnt[1], so that it is watched.
+    int backjump_level = 0;
+    for (size_t i = 1; i < learnt.size(); ++i) {
+        Variable* var = &variables[abs(learnt[i])];
+        var->seen = false;
+        if (var->level > backjump_level) {
+            backjump_level = var->level;
+            swap(learnt[1], learnt[i]);
         }
     }
-    cout << "s UNSATISFIABLE\n";
-    exit(0);
-}
-
-int main(int argc, const char* argv[]) {
-    string filename;
-     
-    for (int i = 1; i < argc; ++i) {
-        string option = string(argv[i]);
-        
-        if (option[0] == '-') {
-            if (option == "-slis") { heu = Heuristic::slis; }
-            else if (option == "-slcs") { heu = Heuristic::slcs; }
-            else if (option == "-dlis") { heu = Heuristic::dlis; }
-            else if (option == "-dlcs") { heu = Heuristic::dlcs; }
-            else if (option == "-bc") { heu = Heuristic::backtrack_count; }
-            else if (option == "-mom") { heu = Heuristic::mom; }
-            else if (option == "-boehm") { heu = Heuristic::boehm; }
-            else if (option == "-jw") { heu = Heuristic::jw; }
-            else if (option == "-p") { use_pure_lit = true; }
-            else {
-                cout << "Unknown argument: " << option << "\nPossible options:\n";
-                cout << "-slis\tuse the S(tatic)LIS heuristic\n";
-                cout << "-slcs\tuse the S(tatic)LCS heuristic\n";
-                cout << "-dlis\tuse the DLIS heuristic\n";
-                cout << "-dlcs\tuse the DLCS heuristic\n";
-                cout << "-bc\tbacktrack count: a heuristic based on how many times a variable has been backtracked\n";
-                cout << "-mom\tuse the MOM heuristic\n";
-                cout << "-boehm\tuse Boehm's heuristic\n";
-                cout << "-jw\tuse the Jeroslow-Wang heuristic\n";
-                cout << "-p\tenable pure literal elimination\n";
-                exit(1);
+    vector<int> levels;
+    for (int lit: learnt) { levels.push_back(variables[abs(lit)].level); }
+    sort(levels.begin(), levels.end());
+    int lbd = unique(levels.begin(), levels.end()) - levels.begin();
+    record_conflict(lbd);
+
+    // The learned clause is also unit on the root level, which the search must not leave.
+    backtrack_to(max(backjump_level, root_level));
+
+    // Reduce the learned clauses while none of them is waiting in unit_clauses or conflict_clause.
+    if (--conflicts_until_reduce == 0 || memory_short()) {
+        reduce_learnt();
+        reduce_interval += 300;
+        conflicts_until_reduce = reduce_interval;
+    }
+
+    CRef learnt_cr = add_learnt(learnt, lbd);
+    Variable* uip_var = &variables[abs(learnt[0])];
+    set(uip_var, (learnt[0] > 0) ? Value::t : Value::f, Mark::forced, learnt_cr);
+    return true;
+}
+
+// Find the assumptions that the conflict in conflict_clause, or the false assumption false_lit, depends on, by following the reasons of the assignments back to the decisions on the root levels. An assignment without a reason above level 0, i.e. a flipped branching literal, is blamed on all decisions up to its level. If the conflict depends on no assumption, the formula itself is unsatisfiable.
+void Solver::analyze_final(int false_lit) {
+    failed.clear();
+    auto mark = [](Variable* var) {
+        if (var->level > 0) { var->seen = true; }
+    };
+    if (false_lit != 0) {
+        failed.push_back(false_lit);
+        mark(&variables[abs(false_lit)]);
+    } else {
+        for (int lit: clauses[conflict_clause]) { mark(&variables[abs(lit)]); }
+    }
+    int blamed_level = 0;  // All decisions up to this level are blamed.
+    size_t first = level_begin.empty() ? assignments.size() : level_begin[0];
+    for (size_t i = assignments.size(); i > first; --i) {
+        Variable* var = assignments[i-1].first;
+        if (!var->seen) { continue; }
+        var->seen = false;
+        if (assignments[i-1].second == Mark::branching) {
+            failed.push_back(true_lit(var));
+        } else if (var->reason == no_clause) {
+            blamed_level = max(blamed_level, var->level);
+        } else {
+            for (int lit: clauses[var->reason]) {
+                if (abs(lit) != index_of(var)) { mark(&variables[abs(lit)]); }
             }
-        } else { filename = option; }
+        }
     }
-    // When no file name is given.
-    if (filename == "") {
-        cout << "No filename specified\n";
-        cout << "usage: dpll_solver <path to a cnf file> [-p] [heuristics]\n";
-        exit(1);
+    for (int l = 0; l < blamed_level; ++l) {
+        int lit = true_lit(assignments[level_begin[l]].first);
+        if (find(failed.begin(), failed.end(), lit) == failed.end()) { failed.push_back(lit); }
     }
+    if (failed.empty()) { inconsistent = true; }
+}
 
-    if (heu == Heuristic::dlis || heu == Heuristic::dlcs || heu == Heuristic::mom || heu == Heuristic::boehm || use_pure_lit) {
-        update_active_occ = true;
+// Assign the literals of a cube as decisions on their own levels, which become the root of the search. Return false if the cube contradicts the formula, and find the assumptions responsible in failed.
+bool Solver::assume(const vector<int>& cube) {
+    failed.clear();
+    if (inconsistent) { return false; }
+    unit_prop();
+    pure_lit();
+    for (int lit: cube) {
+        if (conflict_clause != no_clause) { break; }
+        if (lit_value(lit) == Value::f) {
+            analyze_final(lit);
+            return false;
+        }
+        if (lit_value(lit) == Value::t) { continue; }
+        level_begin.push_back(assignments.size());
+        set(&variables[abs(lit)], (lit > 0) ? Value::t : Value::f, Mark::branching);
+        unit_prop();
+        pure_lit();
     }
+    root_level = level_begin.size();
+    if (conflict_clause != no_clause) {
+        analyze_final();
+        return false;
+    }
+    return true;
+}
 
-    fromFile(filename);
-    // Fill the unassigned_vars heap. Originally all variables are unassigned.
-    for (int i = 1; i < variables.size(); ++i) {
-        unassigned_vars.insert(&variables[i]);
+// Split off the unexplored branch of the first decision above the root: the decision joins this solver's cube, and the cube with the decision negated is returned for another worker.
+vector<int> Solver::split() {
+    vector<int> cube;
+    for (int l = 0; l <= root_level; ++l) { cube.push_back(true_lit(assignments[level_begin[l]].first)); }
+    cube.back() = -cube.back();
+    ++root_level;
+    return cube;
+}
+
+// Undo all decisions, so that the solver can take the next cube. Learned clauses are kept, and the learned unit clauses are asserted again on level 0. The unit clauses that wait to be propagated on level 0 stay.
+void Solver::reset() {
+    conflict_clause = no_clause;
+    root_level = 0;
+    if (!level_begin.empty()) {
+        unit_clauses.clear();
+        backtrack_to(0);
+    }
+    unit_clauses.insert(unit_clauses.end(), learnt_units.begin(), learnt_units.end());
+    learnt_units.clear();
+}
+
+// Print a line with the most important counters if progress_interval seconds have passed since the last one.
+void Solver::report_progress() {
+    auto now = chrono::steady_clock::now();
+    if (chrono::duration<double>(now - last_progress).count() < progress_interval) { return; }
+    last_progress = now;
+    cout << "c progress: " << stats.decisions << " decisions, " << stats.conflicts << " conflicts, " << stats.propagations << " propagations, " << stats.restarts << " restarts, " << learnt_clauses.size() << " learned clauses, " << level_begin.size() << " decision levels" << endl;
+}
+
+// Open a new decision level with a branching literal.
+void Solver::decide(Variable* var, Value value) {
+    STAT(++stats.decisions);
+    STAT(if (progress_interval > 0 && stats.decisions % 4096 == 0) { report_progress(); });
+    level_begin.push_back(assignments.size());
+    set(var, value, Mark::branching);
+}
+
+// Add a clause to the proof together with the negations of all current decisions, i.e. the clause that says that the literals follow from the decisions.
+void Solver::log_with_decisions(vector<int> lits) {
+    for (size_t begin: level_begin) { lits.push_back(-true_lit(assignments[begin].first)); }
+    proof->add(lits);
+}
+
+// Assign a literal tentatively on a new decision level, propagate it and undo everything again, including the saved phases. Return the number of assignments, including the literal itself, or -1 if propagation ran into a conflict. The implied literals are collected in implied_lits.
+int Solver::probe(int lit, vector<int>& implied_lits) {
+    STAT(++stats.lookaheads);
+    size_t begin = assignments.size();
+    level_begin.push_back(begin);
+    set(&variables[abs(lit)], (lit > 0) ? Value::t : Value::f, Mark::branching);
+    unit_prop();
+    bool failed_lit = conflict_clause != no_clause;
+    implied_lits.clear();
+    probed_phases.clear();
+    for (size_t i = begin; i < assignments.size(); ++i) {
+        Variable* var = assignments[i].first;
+        if (i > begin) { implied_lits.push_back(true_lit(var)); }
+        probed_phases.push_back({var, var->saved_phase});
+    }
+    int reduction = assignments.size() - begin;
+    backtrack_to(level_begin.size()-1);
+    for (auto& phase: probed_phases) { phase.first->saved_phase = phase.second; }
+    conflict_clause = no_clause;
+    unit_clauses.clear();
+    return failed_lit ? -1 : reduction;
+}
+
+// Assign a literal that lookahead has found to follow from the current assignment on the current decision level, without a decision.
+void Solver::force(int lit) {
+    set(&variables[abs(lit)], (lit > 0) ? Value::t : Value::f, Mark::forced);
+}
+
+// Lookahead branching: propagate both literals of the most promising unassigned variables and branch on the variable whose two branches both simplify the formula the most. Instead of a decision, a failed literal is forced to false, and the literals that both branches of a variable imply are forced to true. The candidates are the variables with the highest Jeroslow-Wang scores, which bounds the cost of a decision.
+void Solver::lookahead() {
+    candidates.clear();
+    for (size_t i = 1; i < variables.size(); ++i) {
+        if (variables[i].value == Value::unset) { candidates.push_back(&variables[i]); }
     }
-    // There could be unit clauses in the original formula. If unit-propagation and pure literal elimination solve the whole formula, the following while-loop will not be executed.
+    size_t n = min(candidates.size(), (size_t)lookahead_candidates);
+    partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(), [](Variable* v1, Variable* v2) { return v1->jw_pos + v1->jw_neg > v2->jw_pos + v2->jw_neg; });
+    candidates.resize(n);
+    implied_stamp.resize(variables.size(), 0);
+
+    Variable* best = nullptr;
+    Value best_value = Value::unset;
+    long long best_score = -1;
+    for (Variable* var: candidates) {
+        int var_ind = index_of(var);
+        int pos = probe(var_ind, implied[0]);
+        int neg = (pos < 0) ? 0 : probe(-var_ind, implied[1]);
+        if (pos < 0 || neg < 0) {
+            // If both literals fail, the current assignment is conflicting, which the propagation of the forced literal finds.
+            STAT(++stats.failed_literals);
+            int lit = (pos < 0) ? -var_ind : var_ind;
+            if (proof != nullptr) { log_with_decisions({lit}); }
+            force(lit);
+            return;
+        }
+        // A literal implied by both branches follows from the current assignment.
+        if (++round == numeric_limits<int>::max()) {
+            fill(implied_stamp.begin(), implied_stamp.end(), 0);
+            round = 1;
+        }
+        for (int lit: implied[0]) { implied_stamp[abs(lit)] = (lit > 0) ? round : -round; }
+        bool necessary = false;
+        for (int lit: implied[1]) {
+            if (implied_stamp[abs(lit)] != ((lit > 0) ? round : -round) || lit_value(lit) != Value::unset) { continue; }
+            if (proof != nullptr) {
+                log_with_decisions({-var_ind, lit});
+                log_with_decisions({var_ind, lit});
+                log_with_decisions({lit});
+            }
+            force(lit);
+            necessary = true;
+        }
+        if (necessary) { return; }
+        // Prefer variables whose both branches reduce the formula, then the total reduction.
+        long long score = (long long)pos * neg * 1024 + pos + neg;
+        if (score > best_score) {
+            best = var;
+            best_score = score;
+            // Take the branch that assigns fewer variables first, since it leaves more freedom for a model.
+            best_value = (pos <= neg) ? Value::t : Value::f;
+        }
+    }
+    if (restart != Restart::none && best->saved_phase != Value::unset) { best_value = best->saved_phase; }
+    decide(best, best_value);
+}
+
+// Search for a satisfying assignment. Return Result::unknown if the search was cancelled.
+Result Solver::solve() {
+    STAT(ScopedTimer timer(stats.solve_time));
+    // There could be unit clauses in the original formula, which are propagated before the first decision.
     unit_prop();
     pure_lit();
 
-    while (variables.size()-1 != assignments.size()) {
-        // Always pick the variable of highest priority to branch on.
-        Variable* picked_var = unassigned_vars.max();
-        picked_var->set(pick_polarity(picked_var), Mark::branching);
+    // The search is an explicit loop over the trail instead of a recursion, so that it runs in constant stack space.
+    while (true) {
+        if (stop != nullptr && stop->load(memory_order_relaxed)) { return Result::unknown; }
+        if (conflict_clause != no_clause) {
+            STAT(++stats.conflicts);
+            if (!(use_cdcl ? backjump() : backtrack())) {
+                analyze_final();
+                return Result::unsat;
+            }
+        } else if (cube_queue != nullptr && cube_queue->hungry.load(memory_order_relaxed) > 0 && (int)level_begin.size() > root_level) {
+            cube_queue->donate(*this);
+            continue;
+        } else if (variables.size()-1 == assignments.size()) {
+            return Result::sat;
+        } else if (restart_due()) {
+            restart_search();
+        } else if (heu == Heuristic::lookahead) {
+            lookahead();
+        } else {
+            // Always pick the variable of highest priority to branch on.
+            Variable* picked_var = unassigned_vars.max();
+            decide(picked_var, pick_polarity(picked_var));
+        }
         unit_prop();
         pure_lit();
     }
-    cout << "s SATISFIABLE\n";
-    cout << "v ";
-    for (int i = 1; i < variables.size(); ++i) {
-        cout << ((variables[i].value == Value::t) ? i : -i) << " ";
+}
+
+// Continue the search after a model as if its last decision had led to a conflict, so that every model is found exactly once. Return Result::unsat when there is no further model.
+Result Solver::next_model() {
+    if (!backtrack()) { return Result::unsat; }
+    return solve();
+}
+
+// Extend the variables up to index num_vars. The vector may move, therefore the pointers into it are translated to indices and back.
+void Solver::add_vars(int num_vars) {
+    auto indices = [this](auto& pointers) {
+        vector<int> result;
+        for (Variable* var: pointers) { result.push_back((var == nullptr) ? -1 : index_of(var)); }
+        return result;
+    };
+    auto restore = [this](auto& pointers, const vector<int>& ind) {
+        for (size_t i = 0; i < ind.size(); ++i) { pointers[i] = (ind[i] < 0) ? nullptr : &variables[ind[i]]; }
+    };
+    vector<int> heap_ind = indices(unassigned_vars.heap);
+    vector<int> dirty_ind = indices(unassigned_vars.dirty);
+    vector<int> trail_ind;
+    for (auto& assignment: assignments) { trail_ind.push_back(index_of(assignment.first)); }
+
+    int old_size = variables.size();
+    variables.resize(num_vars+1);
+    // The literal values are centered on the number of variables, therefore they all move.
+    vector<uint8_t> old_values = move(lit_values);
+    lit_values.assign(2*num_vars + 1 + gather_padding, uint8_t(Value::unset));
+    for (int i = 1; i < old_size; ++i) {
+        values_by_lit()[i] = old_values[old_size-1 + i];
+        values_by_lit()[-i] = old_values[old_size-1 - i];
+    }
+    restore(unassigned_vars.heap, heap_ind);
+    restore(unassigned_vars.dirty, dirty_ind);
+    for (size_t i = 0; i < trail_ind.size(); ++i) { assignments[i].first = &variables[trail_ind[i]]; }
+
+    for (int i = old_size; i <= num_vars; ++i) {
+        if (heu == Heuristic::none) { variables[i].priority = rng.priority(); }
+        variables[i].update_priority(heu);
+        unassigned_vars.insert(&variables[i]);
+    }
+}
+
+// Add a clause between two calls of solve(assumptions), which undoes the assignments of the last call. Literals that are false on level 0 are dropped, and a clause that is true there is skipped. Return false if the formula has become unsatisfiable. Only watched literals support new clauses, since the other modes would have to update the active counts of all literals. Otherwise, invalid_argument is thrown, also in builds without asserts.
+bool Solver::add_clause(const vector<int>& lits) {
+    if (!use_watched || use_pure_lit) { throw invalid_argument("add_clause needs watched literals and no pure literal elimination"); }
+    reset();
+    int max_var = 0;
+    for (int lit: lits) { max_var = max(max_var, abs(lit)); }
+    if (max_var >= (int)variables.size()) { add_vars(max_var); }
+
+    vector<int> kept;
+    for (int lit: lits) {
+        Value value = lit_value(lit);
+        if (value == Value::t || find(kept.begin(), kept.end(), -lit) != kept.end()) { return true; }  // satisfied on level 0 or a tautology
+        if (value == Value::unset && find(kept.begin(), kept.end(), lit) == kept.end()) { kept.push_back(lit); }
+    }
+    if (kept.empty()) {
+        inconsistent = true;
+        return false;
+    }
+    CRef cr = clauses.alloc(kept, false);
+    original_words += ClauseArena::words(clauses[cr]);
+    if (kept.size() == 1) {
+        unit_clauses.push_back(cr);
+    } else {
+        watch_list(kept[0]).push_back(cr);
+        watch_list(kept[1]).push_back(cr);
+    }
+    for (int lit: kept) {
+        Variable* var = &variables[abs(lit)];
+        ++((lit > 0) ? var->pos_count : var->neg_count);
+        unassigned_vars.touch(var);
+    }
+    return true;
+}
+
+// Solve the formula under assumptions, which are literals that have to be true. If the result is Result::unsat, failed contains the assumptions that are responsible for it, and it is empty if the formula is unsatisfiable without any assumptions. The model of a satisfiable call stays in variables until the next call of solve or add_clause. Pure literal elimination would be unsound under assumptions, so it throws invalid_argument.
+Result Solver::solve(const vector<int>& assumptions) {
+    if (use_pure_lit) { throw invalid_argument("solve with assumptions cannot use pure literal elimination"); }
+    reset();
+    for (int lit: assumptions) {
+        if (abs(lit) >= (int)variables.size()) { add_vars(abs(lit)); }
+    }
+    if (!assume(assumptions)) { return Result::unsat; }
+    return solve();
+}
+
+// The configurations of the portfolio mode, roughly ordered by how many of our benchmarks they solve. --portfolio N runs the first N of them.
+const vector<Config> portfolio_configs = {
+    {Heuristic::backtrack_count, false, true, true},
+    {Heuristic::boehm, false, false, false},
+    {Heuristic::jw, false, false, false},
+    {Heuristic::mom, true, false, false},
+    {Heuristic::dlis, false, false, false},
+    {Heuristic::backtrack_count, false, true, false},
+    {Heuristic::dlcs, true, false, false},
+    {Heuristic::none, false, true, true},
+    {Heuristic::boehm, true, false, false},
+    {Heuristic::jw, true, false, false},
+    {Heuristic::mom, false, false, false},
+    {Heuristic::dlis, true, false, false},
+    {Heuristic::dlcs, false, false, false},
+    {Heuristic::slis, false, true, false},
+    {Heuristic::slcs, false, true, false},
+    {Heuristic::backtrack_count, true, false, false},
+    {Heuristic::backtrack_count, false, false, false},
+    {Heuristic::slis, true, false, false},
+    {Heuristic::slcs, true, false, false},
+    {Heuristic::slis, false, false, false},
+    {Heuristic::slcs, false, false, false},
+    {Heuristic::none, false, true, false},
+    {Heuristic::none, true, false, false},
+    {Heuristic::none, false, false, false},
+};
+
+// Wait for a cube. Return false when there is no work left, i.e. all workers are idle, or when a model has been found.
+bool CubeQueue::pop(vector<int>& cube) {
+    unique_lock<mutex> lock(m);
+    ++idle;
+    ++hungry;
+    while (cubes.empty() && idle < workers && !stop) { cv.wait(lock); }
+    if (cubes.empty() || stop) {
+        cv.notify_all();
+        return false;
+    }
+    cube = move(cubes.back());
+    cubes.pop_back();
+    --idle;
+    --hungry;
+    return true;
+}
+
+// Split the solver's cube if there are more idle workers than waiting cubes.
+void CubeQueue::donate(Solver& solver) {
+    lock_guard<mutex> lock(m);
+    if ((int)cubes.size() < hungry) {
+        cubes.push_back(solver.split());
+        cv.notify_one();
+    }
+}
+
+// Cube and conquer: n workers with their own solvers start from the empty cube. Whenever a worker is idle, a busy worker gives away the other branch of its first decision, so the cubes are split along the variables that the heuristic picks first. The formula is unsatisfiable when all cubes are refuted. The statistics of all workers are added up.
+Result solve_cubes(const Formula& formula, const Config& config, int n, vector<Value>& model, Stats& stats) {
+    CubeQueue queue(n);
+    queue.cubes.push_back({});
+    Result result = Result::unsat;
+    vector<thread> threads;
+    for (int i = 0; i < n; ++i) {
+        threads.emplace_back([&, i]() {
+            Config worker_config = config;
+            worker_config.seed = config.seed + i;
+            Solver solver(formula, worker_config, &queue.stop);
+            solver.cube_queue = &queue;
+            vector<int> cube;
+            while (queue.pop(cube)) {
+                if (solver.assume(cube) && solver.solve() == Result::sat) {
+                    lock_guard<mutex> lock(queue.m);
+                    if (!queue.stop) {
+                        result = Result::sat;
+                        queue.stop = true;
+                        for (Variable& var: solver.variables) { model.push_back(var.value); }
+                    }
+                    queue.cv.notify_all();
+                    break;
+                }
+                solver.reset();
+            }
+            lock_guard<mutex> lock(queue.m);
+            stats += solver.stats;
+        });
+    }
+    for (thread& t: threads) { t.join(); }
+    return result;
+}
+
+// Run the first n configurations of the portfolio in parallel threads. The first solver that finds the answer cancels the others. Return the answer and the model and statistics of the winner.
+Result solve_portfolio(const Formula& formula, int n, uint64_t seed, vector<Value>& model, Stats& stats) {
+    atomic<bool> stop(false);
+    mutex winner_mutex;
+    Result result = Result::unknown;
+    vector<thread> threads;
+    for (int i = 0; i < n; ++i) {
+        threads.emplace_back([&, i]() {
+            Config config = portfolio_configs[i];
+            config.seed = seed + i;
+            Solver solver(formula, config, &stop);
+            Result r = solver.solve();
+            if (r == Result::unknown) { return; }
+            lock_guard<mutex> lock(winner_mutex);
+            if (result != Result::unknown) { return; }
+            result = r;
+            stop = true;
+            cout << "c portfolio winner: " << portfolio_configs[i].name() << "\n";
+            for (Variable& var: solver.variables) { model.push_back(var.value); }
+            stats += solver.stats;
+        });
+    }
+    for (thread& t: threads) { t.join(); }
+    return result;
+}
+
+// Solve many formulas with a pool of worker threads. Each worker has its own formula and solver, whose memory is reused from one formula to the next. The file "-" stands for a stream of concatenated DIMACS problems on stdin, which the workers take turns to parse. Every answer is printed as soon as it is known, in a line with the name of the problem, the answer and the time it took, including parsing.
+void solve_batch(const vector<string>& files, const Config& config, bool preprocess, int workers, ostream& out) {
+    mutex input_mutex;  // guards next_file and the stream on stdin
+    size_t next_file = 0;
+    DimacsInput stream;
+    if (find(files.begin(), files.end(), "-") != files.end()) { stream.open_stream(STDIN_FILENO); }
+    int stream_problems = 0;
+    mutex out_mutex;
+    int counts[3] = {0, 0, 0};  // satisfiable, unsatisfiable, unreadable
+    auto start = chrono::steady_clock::now();
+
+    auto work = [&]() {
+        Formula formula;
+        unique_ptr<Solver> solver;
+        while (true) {
+            formula.clear();
+            string name;
+            bool parsed = false;
+            chrono::steady_clock::time_point problem_start;  // taken before parsing, for files and stdin alike
+            {
+                lock_guard<mutex> lock(input_mutex);
+                while (next_file < files.size() && files[next_file] == "-" && !stream.next_problem()) { ++next_file; }
+                if (next_file == files.size()) { return; }
+                problem_start = chrono::steady_clock::now();
+                if (files[next_file] == "-") {
+                    name = "stdin:" + to_string(++stream_problems);
+                    parsed = parse_dimacs(stream, formula);
+                } else {
+                    name = files[next_file++];
+                }
+            }
+            if (name.compare(0, 6, "stdin:") != 0) {
+                DimacsInput in;
+                parsed = in.open(name) && parse_dimacs(in, formula);
+                in.close();
+            }
+            int answer = 2;
+            if (parsed) {
+                bool sat_possible = !formula.empty_clause;
+                if (sat_possible && preprocess) { sat_possible = Preprocessor(formula).run(); }
+                Result result = Result::unsat;
+                if (sat_possible) {
+                    if (solver == nullptr) { solver = make_unique<Solver>(formula, config); }
+                    else { solver->load(formula); }
+                    result = solver->solve();
+                }
+                answer = (result == Result::sat) ? 0 : 1;
+            }
+            chrono::duration<double> time = chrono::steady_clock::now() - problem_start;
+            const char* answers[] = {"SATISFIABLE", "UNSATISFIABLE", "ERROR"};
+            lock_guard<mutex> lock(out_mutex);
+            ++counts[answer];
+            out << name << " " << answers[answer] << " " << time.count() << "s" << endl;
+        }
+    };
+    vector<thread> threads;
+    for (int i = 0; i < workers; ++i) { threads.emplace_back(work); }
+    for (thread& t: threads) { t.join(); }
+    stream.close();
+    chrono::duration<double> total = chrono::steady_clock::now() - start;
+    out << "c batch: " << counts[0] << " satisfiable, " << counts[1] << " unsatisfiable, " << counts[2] << " unreadable in " << total.count() << "s" << endl;
+}
+
+BigCount::BigCount(uint64_t value) {
+    for (; value != 0; value >>= 32) { limbs.push_back(uint32_t(value)); }
+}
+
+BigCount& BigCount::operator+=(const BigCount& other) {
+    if (limbs.size() < other.limbs.size()) { limbs.resize(other.limbs.size(), 0); }
+    uint64_t carry = 0;
+    for (size_t i = 0; i < limbs.size() && (carry != 0 || i < other.limbs.size()); ++i) {
+        carry += uint64_t(limbs[i]) + ((i < other.limbs.size()) ? other.limbs[i] : 0);
+        limbs[i] = uint32_t(carry);
+        carry >>= 32;
+    }
+    if (carry != 0) { limbs.push_back(uint32_t(carry)); }
+    return *this;
+}
+
+BigCount BigCount::operator*(const BigCount& other) const {
+    BigCount product;
+    if (is_zero() || other.is_zero()) { return product; }
+    product.limbs.assign(limbs.size() + other.limbs.size(), 0);
+    for (size_t i = 0; i < limbs.size(); ++i) {
+        uint64_t carry = 0;  // A product of two digits plus two more digits still fits into 64 bits.
+        for (size_t j = 0; j < other.limbs.size(); ++j) {
+            carry += uint64_t(limbs[i]) * other.limbs[j] + product.limbs[i+j];
+            product.limbs[i+j] = uint32_t(carry);
+            carry >>= 32;
+        }
+        product.limbs[i + other.limbs.size()] = uint32_t(carry);
+    }
+    while (product.limbs.back() == 0) { product.limbs.pop_back(); }
+    return product;
+}
+
+// Multiply by 2^bits.
+void BigCount::shift(int bits) {
+    if (is_zero() || bits == 0) { return; }
+    int rest = bits % 32;
+    if (rest != 0) {
+        uint32_t carry = 0;
+        for (uint32_t& limb: limbs) {
+            uint32_t next = limb >> (32 - rest);
+            limb = (limb << rest) | carry;
+            carry = next;
+        }
+        if (carry != 0) { limbs.push_back(carry); }
+    }
+    limbs.insert(limbs.begin(), bits / 32, 0);
+}
+
+// Return the decimal digits, which are found 9 at a time by dividing by 10^9.
+string BigCount::to_string() const {
+    if (is_zero()) { return "0"; }
+    vector<uint32_t> rest = limbs;
+    vector<uint32_t> chunks;  // the digits in base 10^9, least significant first
+    while (!rest.empty()) {
+        uint64_t remainder = 0;
+        for (size_t i = rest.size(); i-- > 0;) {
+            uint64_t current = (remainder << 32) | rest[i];
+            rest[i] = uint32_t(current / 1000000000);
+            remainder = current % 1000000000;
+        }
+        chunks.push_back(uint32_t(remainder));
+        while (!rest.empty() && rest.back() == 0) { rest.pop_back(); }
+    }
+    string digits = std::to_string(chunks.back());
+    for (size_t i = chunks.size()-1; i-- > 0;) {
+        string chunk = std::to_string(chunks[i]);
+        digits += string(9 - chunk.size(), '0') + chunk;
+    }
+    return digits;
+}
+
+// FNV-1a over the literals and separators.
+size_t ClausesHash::operator()(const vector<int>& flat) const {
+    uint64_t hash = 14695981039346656037ull;
+    for (int lit: flat) { hash = (hash ^ uint32_t(lit)) * 1099511628211ull; }
+    return hash;
+}
+
+ModelCounter::ModelCounter(Formula& formula)
+    : num_vars(formula.num_vars), values(formula.num_vars+1, Value::unset), parent(formula.num_vars+1, 0), occurrences(formula.num_vars+1, 0), component_of(formula.num_vars+1, 0), occ_lists(2*formula.num_vars+1) {
+    for (CRef cr = 0; cr < formula.clauses.memory.size(); cr += ClauseArena::words(formula.clauses[cr])) {
+        Clause& cl = formula.clauses[cr];
+        if (!cl.deleted) { clauses.emplace_back(cl.begin(), cl.end()); }
+    }
+    if (formula.empty_clause) { clauses.push_back({}); }
+}
+
+// Assign lit, unless it is 0, and propagate the unit clauses of in. Return false on a conflict. Otherwise, out receives the clauses that are not satisfied without their false literals, and assigned the number of assigned variables.
+bool ModelCounter::propagate(const vector<vector<int>>& in, int lit, vector<vector<int>>& out, int& assigned) {
+    auto value = [this](int l) {
+        Value v = values[abs(l)];
+        if (v == Value::unset || l > 0) { return v; }
+        return (v == Value::t) ? Value::f : Value::t;
+    };
+    auto assign = [this](int l) {
+        values[abs(l)] = (l > 0) ? Value::t : Value::f;
+        trail.push_back(l);
+    };
+    open.resize(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        open[i] = in[i].size();
+        for (int l: in[i]) { occ_lists[l + num_vars].push_back(i); }
+    }
+    bool conflict = false;
+    for (size_t i = 0; i < in.size() && !conflict; ++i) {
+        if (in[i].size() == 1 && value(in[i][0]) == Value::unset) { assign(in[i][0]); }
+        conflict = in[i].empty();
+    }
+    if (lit != 0 && !conflict) {
+        if (value(lit) == Value::f) { conflict = true; }
+        if (value(lit) == Value::unset) { assign(lit); }
+    }
+    // Only the clauses of a literal that has become false can become unit. They are scanned once fewer than two of their literals are left that have not been propagated as false.
+    for (size_t head = 0; head < trail.size() && !conflict; ++head) {
+        for (int i: occ_lists[-trail[head] + num_vars]) {
+            if (--open[i] > 1) { continue; }
+            int unassigned = 0;
+            bool satisfied = false;
+            for (int l: in[i]) {
+                Value v = value(l);
+                if (v == Value::t) { satisfied = true; break; }
+                if (v == Value::unset) { unassigned = l; }
+            }
+            if (satisfied) { continue; }
+            if (unassigned == 0) { conflict = true; break; }
+            assign(unassigned);
+        }
+    }
+    out.clear();
+    for (const vector<int>& cl: in) {
+        for (int l: cl) { occ_lists[l + num_vars].clear(); }
+        if (conflict) { continue; }
+        if (any_of(cl.begin(), cl.end(), [&value](int l) { return value(l) == Value::t; })) { continue; }
+        out.emplace_back();
+        copy_if(cl.begin(), cl.end(), back_inserter(out.back()), [&value](int l) { return value(l) == Value::unset; });
+    }
+    assigned = trail.size();
+    for (int l: trail) { values[abs(l)] = Value::unset; }
+    trail.clear();
+    return !conflict;
+}
+
+// Split clauses into the components that share no variable. The literals and clauses of every component are sorted, so that equal components get equal cache keys. num_comp_vars receives the number of variables of each component.
+vector<vector<vector<int>>> ModelCounter::split(vector<vector<int>>& in, vector<int>& num_comp_vars) {
+    auto root = [this](int var) {
+        while (parent[var] != var) {
+            parent[var] = parent[parent[var]];
+            var = parent[var];
+        }
+        return var;
+    };
+    for (const vector<int>& cl: in) {
+        for (int lit: cl) { parent[abs(lit)] = abs(lit); }
+    }
+    for (const vector<int>& cl: in) {
+        for (int lit: cl) {
+            int r1 = root(abs(cl[0]));
+            int r2 = root(abs(lit));
+            if (r1 != r2) { parent[r2] = r1; }
+        }
+    }
+    vector<vector<vector<int>>> comps;
+    for (vector<int>& cl: in) {
+        int& comp = component_of[root(abs(cl[0]))];
+        if (comp == 0) {
+            comps.emplace_back();
+            comp = comps.size();
+        }
+        sort(cl.begin(), cl.end());
+        comps[comp-1].push_back(move(cl));
+    }
+    num_comp_vars.clear();
+    vector<int> vars;
+    for (vector<vector<int>>& comp: comps) {
+        component_of[root(abs(comp[0][0]))] = 0;
+        sort(comp.begin(), comp.end());
+        vars.clear();
+        for (const vector<int>& cl: comp) {
+            for (int lit: cl) { vars.push_back(abs(lit)); }
+        }
+        sort(vars.begin(), vars.end());
+        num_comp_vars.push_back(unique(vars.begin(), vars.end()) - vars.begin());
+    }
+    return comps;
+}
+
+// Propagate lit, unless it is 0, in the clauses in over num_in_vars variables and split the rest into components. The product of the split starts at 0 on a conflict, and at 1 otherwise.
+ModelCounter::SplitFrame ModelCounter::open_split(const vector<vector<int>>& in, int lit, int num_in_vars) {
+    SplitFrame frame;
+    vector<vector<int>> rest;
+    int assigned;
+    if (!propagate(in, lit, rest, assigned)) { return frame; }
+    frame.comps = split(rest, frame.num_comp_vars);
+    frame.product = BigCount(1);
+    frame.free_vars = num_in_vars - assigned;
+    return frame;
+}
+
+// Count the models of the whole formula. The components of a split are counted one after the other, each by branching on its most frequent variable, unless the cache has its count, and every variable that no clause of a split contains anymore doubles its count. The branches are kept on explicit stacks, like the main search, so deep formulas cannot overflow the call stack.
+BigCount ModelCounter::count() {
+    vector<SplitFrame> splits;
+    vector<ComponentFrame> frames;  // frames[i] is being counted by splits[i+1]
+    splits.push_back(open_split(clauses, 0, num_vars));
+    while (true) {
+        SplitFrame& split_frame = splits.back();
+        if (split_frame.next < split_frame.comps.size() && !split_frame.product.is_zero()) {
+            ComponentFrame frame;
+            frame.clauses = move(split_frame.comps[split_frame.next]);
+            frame.num_vars = split_frame.num_comp_vars[split_frame.next];
+            split_frame.free_vars -= frame.num_vars;
+            ++split_frame.next;
+            for (const vector<int>& cl: frame.clauses) {
+                frame.key.insert(frame.key.end(), cl.begin(), cl.end());
+                frame.key.push_back(0);
+            }
+            auto cached = cache.find(frame.key);
+            if (cached != cache.end()) {
+                ++cache_hits;
+                split_frame.product = split_frame.product * cached->second;
+                continue;
+            }
+            ++components;
+            frame.best = 0;  // occurrences[0] stays 0
+            for (const vector<int>& cl: frame.clauses) {
+                for (int lit: cl) {
+                    if (++occurrences[abs(lit)] > occurrences[frame.best]) { frame.best = abs(lit); }
+                }
+            }
+            for (const vector<int>& cl: frame.clauses) {
+                for (int lit: cl) { occurrences[abs(lit)] = 0; }
+            }
+            frames.push_back(move(frame));
+            splits.push_back(open_split(frames.back().clauses, frames.back().best, frames.back().num_vars));
+            continue;
+        }
+        // The split is finished, so its count goes to the branch of the component that opened it.
+        BigCount product = move(split_frame.product);
+        product.shift(split_frame.free_vars);
+        splits.pop_back();
+        if (frames.empty()) { return product; }
+        ComponentFrame& frame = frames.back();
+        frame.total += product;
+        if (!frame.second_branch) {
+            frame.second_branch = true;
+            splits.push_back(open_split(frame.clauses, -frame.best, frame.num_vars));
+            continue;
+        }
+        if (cache.size() >= cache_limit) { cache.clear(); }
+        splits.back().product = splits.back().product * frame.total;
+        cache.emplace(move(frame.key), move(frame.total));
+        frames.pop_back();
     }
-    cout << "0\n";
-    return 0;
 }
@@ -2,27 +2,191 @@
 #define DPLL_SOLVER_H
 
 #include <iostream>
-#include <fstream> 
 #include <vector>
-#include <set> 
-#include <deque> 
 #include <string>
+#include <cstring>
 #include <cassert>
-#include <map>
 #include <cmath> 
 #include <limits>
 #include <cstdlib>
+#include <algorithm>
+#include <cstdint>
+#include <cerrno>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <fstream>
+#include <unordered_map>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <lzma.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-struct Variable;
+// The statistics are only counted in builds with -DDPLL_STATS. Otherwise the counting code is compiled out.
+#ifdef DPLL_STATS
+#define STAT(statement) statement
+#else
+#define STAT(statement)
+#endif
 
+// Counters of the work a solver has done, for finding out why a configuration is slow.
+struct Stats {
+    long long decisions = 0;
+    long long propagations = 0;  // assignments forced by unit clauses
+    long long pure_literals = 0;  // assignments by pure literal elimination
+    long long conflicts = 0;
+    long long backtracks = 0;  // the number of decision levels that have been undone
+    long long restarts = 0;
+    long long learnt_clauses = 0;
+    long long lookaheads = 0;  // literals that the lookahead heuristic propagated tentatively
+    long long failed_literals = 0;  // literals that lookahead found to fail
+    long long assignments = 0;
+    long long clause_visits = 0;  // the clauses that Solver::set visited
+    long long heap_moves = 0;  // calls of Heap::move_up and Heap::move_down
+    long long heap_swaps = 0;
+    double parse_time = 0;  // the time spent in fromFile
+    double preprocess_time = 0;
+    double unit_prop_time = 0;
+    double pure_lit_time = 0;
+    double backtrack_time = 0;  // the time spent in backtrack and backjump
+    double solve_time = 0;
+
+    Stats& operator+=(const Stats&);
+    void print(ostream&, const string& prefix = "c ") const;
+    bool write_json(const string& path) const;
+};
+
+// Add the time until the end of the scope to a counter.
+struct ScopedTimer {
+    double& total;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    explicit ScopedTimer(double& total) : total(total) {}
+    ~ScopedTimer() { total += chrono::duration<double>(chrono::steady_clock::now() - start).count(); }
+};
+
+typedef uint32_t CRef;  // A clause is referred to by the offset of its header in the clause arena.
+const CRef no_clause = numeric_limits<CRef>::max();
+
+// A clause is stored in the clause arena as a header that is directly followed by its literals.
 struct Clause {
-    Variable* sat_var = nullptr;  // the variable that first satisfies the clause
-    vector<int> lits;
-    int active;
+    int size;
+    int active;  // the number of literals that are not false, only counted without watched literals
+    int sat_var;  // the index of the variable that first satisfies the clause, 0 if the clause is not satisfied
+    unsigned learnt : 1;  // whether the clause was learned from a conflict
+    unsigned deleted : 1;
+    unsigned lbd : 30;  // literal block distance of a learned clause: the number of different decision levels among its literals
+
+    // With watched literals, the first two literals are the watched ones.
+    int* begin() { return reinterpret_cast<int*>(this + 1); }
+    int* end() { return begin() + size; }
+    int& operator[](int i) { return begin()[i]; }
+};
+
+const size_t clause_header_words = sizeof(Clause) / sizeof(uint32_t);
+static_assert(sizeof(Clause) % sizeof(uint32_t) == 0, "a clause header must consist of whole words");
+
+// The memory of all clause arenas. With a memory limit, a block of at least spill_threshold bytes is placed in a memory-mapped temporary file instead of anonymous memory, so when the memory is short, the kernel writes rarely touched clauses out to the file and reads them back on demand instead of the process being killed. The live and peak sizes of all arenas are counted.
+struct ArenaMemory {
+    static size_t spill_threshold;  // SIZE_MAX for no spilling
+    static atomic<size_t> allocated;
+    static atomic<size_t> peak;
+    static atomic<size_t> spilled;  // the bytes that are currently in files
+    static atomic<size_t> peak_spilled;
+    static mutex m;  // guards mapped
+    static vector<pair<void*, size_t>> mapped;  // the blocks in files
 
-    Clause(vector<int> lits, int active) : lits{lits}, active{active} {}
+    static void* allocate(size_t bytes);
+    static void deallocate(void*, size_t bytes);
+    static void* map_file(size_t bytes);
+};
+
+template<class T>
+struct ArenaAllocator {
+    typedef T value_type;
+    ArenaAllocator() = default;
+    template<class U> ArenaAllocator(const ArenaAllocator<U>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(ArenaMemory::allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { ArenaMemory::deallocate(p, n * sizeof(T)); }
+    bool operator==(const ArenaAllocator&) const { return true; }
+    bool operator!=(const ArenaAllocator&) const { return false; }
+};
+
+// All clauses are stored contiguously in a single vector of 32-bit words, so that propagation does not chase a pointer per clause.
+struct ClauseArena {
+    vector<uint32_t, ArenaAllocator<uint32_t>> memory;
+    size_t wasted = 0;  // the number of words taken by deleted clauses
+
+    Clause& operator[](CRef cr) { return *reinterpret_cast<Clause*>(&memory[cr]); }
+    static size_t words(const Clause& cl) { return clause_header_words + cl.size; }
+
+    CRef alloc(const vector<int>& lits, bool learnt);
+    void free(CRef);
+};
+
+// The number of active clauses of every length that a literal occurs in, for the MOM and Boehm heuristics. An active clause only changes its length by one, so the counts are updated without any allocation. Clauses of long_len or more literals share the last count, so that a literal in a huge clause does not need a count for every length.
+struct ClauseLengths {
+    static constexpr int long_len = 32;
+    int* counts = nullptr;  // counts[len] for 1 <= len <= max_len, where counts[long_len] holds all the longer clauses too
+    static constexpr int none = numeric_limits<int>::max();
+    int max_len = 0;  // the length of the longest clause the literal occurs in, at most long_len
+    int min_len = none;  // the shortest length with a nonzero count, none if there is none
+
+    static int bucket(int len) { return min(len, long_len); }
+    int count(int len) const { return (len <= max_len) ? counts[len] : 0; }
+    void add(int len) {
+        ++counts[bucket(len)];
+        min_len = min(min_len, bucket(len));
+    }
+    void remove(int len) {
+        --counts[bucket(len)];
+        while (min_len <= max_len && counts[min_len] == 0) { ++min_len; }
+        if (min_len > max_len) { min_len = none; }
+    }
+    // A clause of length len becomes one literal shorter.
+    void shrink(int len) {
+        --counts[bucket(len)];
+        ++counts[bucket(len-1)];
+        min_len = min(min_len, bucket(len-1));
+    }
+    // A clause of length len-1 becomes one literal longer.
+    void grow(int len) {
+        --counts[bucket(len-1)];
+        ++counts[bucket(len)];
+        if (min_len == bucket(len-1) && counts[min_len] == 0) { min_len = bucket(len); }
+    }
+};
+
+// A xorshift64* generator of pseudo-random numbers. It takes a few instructions per number, is owned by one solver, and gives the same sequence for a seed on every platform.
+struct Random {
+    uint64_t state;
+    // Spread the bits of the seed with splitmix64, since xorshift needs a nonzero state.
+    explicit Random(uint64_t seed) {
+        uint64_t z = seed + 0x9e3779b97f4a7c15;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        state = (z ^ (z >> 31)) | 1;
+    }
+    uint64_t operator()() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1d;
+    }
+    double priority() { return (*this)() >> 11; }  // a random number that a double represents exactly
+    bool coin() { return (*this)() >> 63; }
 };
 
 // A variable is either unset, false or true.
@@ -35,37 +199,67 @@ enum class Mark {
     forced, branching
 };
 
+enum class Heuristic {
+    none, slis, slcs, dlis, dlcs, backtrack_count, mom, boehm, jw, lookahead
+};
+
+// What propagation without watched literals has to count for a heuristic, known at compile time. The counting code is instantiated once per heuristic, so that its loops over the literals of a clause test no option.
+template<Heuristic heu>
+struct CountingPolicy {
+    static constexpr bool jw = heu == Heuristic::jw || heu == Heuristic::lookahead;  // the Jeroslow-Wang scores, which lookahead preselects its candidates by
+    static constexpr bool by_cl_len = heu == Heuristic::mom || heu == Heuristic::boehm;  // the occurrences by clause length
+    static constexpr bool active_occ = heu == Heuristic::dlis || heu == Heuristic::dlcs || by_cl_len;  // the occurrences in active clauses
+};
+
+// Return the position of the first literal in lits[begin..end) that is not false, or end if all are false. values[lit] is the Value of the literal lit, and there must be 3 readable bytes after the last one. On CPUs with AVX2, the values of 8 literals are gathered and compared at once, otherwise the literals are checked one by one.
+extern int (*first_not_false)(const int* lits, int begin, int end, const uint8_t* values);
+const int gather_padding = 3;  // A gather loads 4 bytes for the value of a literal, of which it uses the first.
+
+// The Jeroslow-Wang weight 2^-len of a clause with len active literals, as a fixed-point number with jw_fraction_bits bits after the point. Integer scores are restored exactly by backtracking, where doubles would drift. Clauses longer than jw_fraction_bits saturate at the smallest weight 1 instead of weighing nothing, so they still break ties, and the 24 bits before the point leave room for millions of clauses.
+const int jw_fraction_bits = 40;
+inline uint64_t jw_weight(int len) { return (len < jw_fraction_bits) ? uint64_t(1) << (jw_fraction_bits - len) : 1; }
+
 struct Variable {
     Value value = Value::unset;
-    vector<Clause*> pos_occ;
-    vector<Clause*> neg_occ;
+    vector<CRef> pos_occ;  // the clauses the positive literal occurs in, only without watched literals
+    vector<CRef> neg_occ;
+    vector<CRef> pos_watch;  // clauses that watch the positive literal
+    vector<CRef> neg_watch;  // clauses that watch the negative literal
     int active_pos_occ = 0;  // Keep track of the occurrence of a positive literal in active clauses.
     int active_neg_occ = 0;  // Keep track of the occurrence of a negative literal in active clauses.
-    int heap_position = 0;  // A variable's position in the heap, which is used to update the heap.
-    map<int,int> pos_by_cl_len;  // the occurrences of a positive literal in active clauses, sorted by clause length
-    map<int,int> neg_by_cl_len;  // the occurrences of a negative literal in active clauses, sorted by clause length
-    double jw_pos = 0;  // Jeroslow-Wang heuristic score for positive literal
-    double jw_neg = 0;  // Jeroslow-Wang heuristic score for negative literal
-    int backtrack_count = 0;  // for the backtrack_count heuristic
-    void set(Value, Mark);
-    void unset();
-};
-
-enum class Heuristic {
-    none, slis, slcs, dlis, dlcs, backtrack_count, mom, boehm, jw
+    int pos_count = 0;  // the number of clauses the positive literal occurs in, which is all the static heuristics need
+    int neg_count = 0;  // the number of clauses the negative literal occurs in
+    int heap_position = 0;  // A variable's position in the heap, which is used to update the heap. 0 if the variable is not in the heap.
+    bool heap_dirty = false;  // whether the variable waits in Heap::dirty to be repositioned
+    ClauseLengths pos_by_cl_len;  // the occurrences of a positive literal in active clauses, counted by clause length
+    ClauseLengths neg_by_cl_len;  // the occurrences of a negative literal in active clauses, counted by clause length
+    uint64_t jw_pos = 0;  // Jeroslow-Wang heuristic score for positive literal, the sum of jw_weight over its active clauses
+    uint64_t jw_neg = 0;  // Jeroslow-Wang heuristic score for negative literal
+    double backtrack_count = 0;  // for the backtrack_count heuristic, in units of Solver::bump_increment
+    Value saved_phase = Value::unset;  // the last value of the variable, which is reused after restarts
+    double priority = 0;  // the cached priority of the variable in the heap, computed by update_priority
+    int level = 0;  // the decision level of the assignment
+    CRef reason = no_clause;  // the clause that forced the assignment, used for conflict analysis
+    bool seen = false;  // marks the variable during conflict analysis
+    void update_priority(Heuristic);
+    void clear();
 };
 
-bool greater_than(Variable*, Variable*);
+bool greater_than(Variable*, Variable*, Heuristic);
 
-struct Heap {  // a max-heap
+// A max-heap that is only brought into order when the maximum is queried. Assigned variables stay in the heap until they reach the top, and variables whose priority changed are only marked as dirty.
+struct Heap {
     vector<Variable*> heap{nullptr}; // Add a dummy element to simplify index computation.
+    vector<Variable*> dirty;  // the variables whose priority has to be recomputed or that have to be reinserted
+    Heuristic heu = Heuristic::none;  // the heuristic that defines the priorities
+    Stats* stats = nullptr;  // the statistics of the solver that owns the heap
 
     static int parent_ind(int ind) { return ind/2; }  // Return the index of the parent node of a node.
     static int l_child_ind(int ind) { return ind*2; }  // Return the index of the left child of a node.
     static int r_child_ind(int ind) { return ind*2+1; }  // Return the index of the right child of a node.
     // Return the index of the child with the maximum priority. When there is no child, return the index of the node.
     int max_child_ind(int i) const { 
-        if (i*2+1 < heap.size()) { return greater_than(heap[i*2], heap[i*2+1]) ? i*2 : i*2+1; } 
+        if (i*2+1 < heap.size()) { return greater_than(heap[i*2], heap[i*2+1], heu) ? i*2 : i*2+1; } 
         else if (i*2 < heap.size()) { return i*2; }
         else { return i; }
     }
@@ -74,11 +268,323 @@ struct Heap {  // a max-heap
     void remove(Variable*);
     void move_up(Variable*);
     void move_down(Variable*);
+    void touch(Variable*);
+    void repair();
+    void rebuild();
     Variable* max();
 };
 
-void pure_lit();
+// The input of the DIMACS parser. Plain files are memory-mapped and scanned in place, gzip and xz files are decompressed from the mapping chunk by chunk, and streams such as stdin are read chunk by chunk.
+struct DimacsInput {
+    enum class Format { plain, gzip, xz, stream };
+    Format format = Format::plain;
+    const char* data = nullptr;  // the memory-mapped file
+    size_t size = 0;
+    int fd = -1;  // the stream
+    z_stream gz;
+    lzma_stream xz;
+    vector<char> buffer;  // the current chunk of decompressed input
+    const char* pos = nullptr;  // the next character to read
+    const char* end = nullptr;
+
+    bool open(const string& path);
+    void open_stream(int fd);
+    bool next_problem();
+    void close();
+    bool refill();
+    int peek() { return (pos != end || refill()) ? *pos : EOF; }
+    void skip_whitespace();
+    void skip_line();
+    bool read_int(int&);
+};
+
+// The parsed formula. It is only read by the solvers, which copy the clauses into their own arena.
+struct Formula {
+    int num_vars = 0;
+    ClauseArena clauses;  // the clauses of the input in their original order, without duplicate literals and tautologies
+    bool empty_clause = false;
+    vector<int> reconstruction;  // the clauses removed by the preprocessing that a model of the rest may falsify, each followed by its length
+    void extend_model(vector<Value>&) const;
+    void clear();
+};
+
+bool parse_dimacs(DimacsInput&, Formula&);
+bool fromFile(string path, Formula&);
+
+// A DRAT proof of unsatisfiability in the binary format, which checkers such as drat-trim read. The clauses are encoded into one buffer while a background thread writes the other one to the file, so a proof of many gigabytes is streamed out without stalling the search for long.
+struct Proof {
+    static const size_t buffer_size = 1 << 22;  // The solver hands a buffer over when it is this full.
+    int fd = -1;
+    vector<uint8_t> filling;  // the buffer that the solver appends to
+    vector<uint8_t> writing;  // the buffer that the writer thread writes, empty when it is idle
+    mutex m;
+    condition_variable cv;
+    bool closing = false;
+    bool failed = false;  // whether a write failed, e.g. because the disk is full
+    thread writer;
+
+    Proof() = default;
+    Proof(const Proof&) = delete;
+    Proof& operator=(const Proof&) = delete;
+    ~Proof() { close(); }
+
+    bool open(const string& path);
+    void record(uint8_t kind, const int* begin, const int* end);
+    void add(const int* begin, const int* end) { record('a', begin, end); }
+    void add(const vector<int>& lits) { add(lits.data(), lits.data() + lits.size()); }
+    void remove(const int* begin, const int* end) { record('d', begin, end); }
+    void remove(const vector<int>& lits) { remove(lits.data(), lits.data() + lits.size()); }
+    void flush();
+    void write_loop();
+    bool close();
+};
+
+// Simplification of a formula before the search: unit propagation, subsumption, self-subsuming strengthening, failed literal probing and bounded variable elimination. Clauses are kept in separate vectors, which are easy to shrink and delete, and are written back into the formula's arena at the end.
+struct Preprocessor {
+    Formula& formula;
+    vector<vector<int>> clauses;
+    vector<bool> removed;
+    vector<bool> queued;  // whether a clause waits in queue
+    vector<vector<int>> occ;  // occ[lit_index(lit)] are the clauses that contain lit, including removed ones until they are cleaned up
+    vector<Value> values;  // the variables fixed on the top level, and the temporary assignments of probing
+    vector<bool> eliminated;
+    vector<bool> marked;  // marks the literals of a clause, indexed by lit_index
+    vector<int> units;
+    vector<int> queue;  // the clauses that may subsume or strengthen other clauses
+    bool unsat = false;
+    long long probe_budget;  // the number of clause visits that probing may still spend
+    Proof* proof = nullptr;  // receives the clauses that are derived and removed
+    static const int max_occ = 16;  // Only variables with at most this many occurrences of one polarity are eliminated.
+    static const int max_resolvent_len = 20;
+
+    static int lit_index(int lit) { return 2*abs(lit) + (lit < 0); }
+    Value lit_value(int);
+    explicit Preprocessor(Formula&);
+    void add_clause(const vector<int>&);
+    vector<int>& occurrences(int);
+    void strengthen(int, int);
+    void save(const vector<int>&, int);
+    bool propagate();
+    void subsume();
+    bool simplify();
+    bool probe_lit(int);
+    void probe();
+    bool resolve(int, int, int, vector<int>&);
+    void eliminate();
+    int count_vars();
+    int count_clauses();
+    bool run();
+};
+
+// When the search starts again from the root level: never, after a number of conflicts that follows the Luby sequence, or when the recent learned clauses have a high LBD compared to the average (as in Glucose).
+enum class Restart {
+    none, luby, glucose
+};
+
+// A combination of the command line options that choose how to solve a formula.
+struct Config {
+    Heuristic heu = Heuristic::none;  // The default setting is without any heuristics.
+    bool use_pure_lit = false;
+    bool use_watched = false;  // use two watched literals per clause instead of counting active literals
+    bool use_cdcl = false;  // learn clauses from conflicts and backjump instead of backtracking chronologically
+    Restart restart = Restart::none;  // Restarts also enable phase saving.
+    uint64_t seed = 1;  // the seed of the random numbers, which only the default heuristic uses
+    size_t mem_limit = 0;  // the number of bytes the solver should stay within, 0 for no limit
+    string name() const;
+};
+
+enum class Result {
+    sat, unsat, unknown
+};
+
+struct CubeQueue;
+
+// The complete state of a search on one formula. Several solvers can run on the same formula in different threads.
+// A solver can also be used as a library: solve(assumptions) can be called many times, with add_clause in between, and keeps the backtrack counts, saved phases and learned clauses from one call to the next. Pure literal elimination cannot be used this way, since a literal that is pure in one call may not be pure in the next.
+struct Solver {
+    Heuristic heu;
+    bool use_pure_lit;
+    bool use_watched;
+    bool use_cdcl;
+    Restart restart;
+    const atomic<bool>* stop;  // When another solver has found the answer, the search is cancelled.
+    CubeQueue* cube_queue = nullptr;  // In the cube-and-conquer mode, the solver gives parts of its cube to idle workers.
+
+    vector<Variable> variables;
+    vector<uint8_t> lit_values;  // the values of all literals, one byte each, by lit + num_vars, which the scans over clauses read instead of the variables
+    ClauseArena clauses;
+    vector<int> cl_len_pool;  // the memory of the clause length counts of all literals
+    vector<pair<Variable*, Mark>> assignments;  // the trail of all assignments in the order they were made
+    vector<size_t> level_begin;  // level_begin[l-1] is the index in assignments of the branching literal of decision level l
+    int root_level = 0;  // The decisions up to this level are the literals of the cube being solved. The search does not backtrack over them.
+    vector<CRef> unit_clauses;
+    CRef conflict_clause = no_clause;  // a clause whose literals are all false under the current assignment
+    Heap unassigned_vars;
+    double bump_increment = 1;  // the amount by which a backtrack count is bumped, which grows instead of all counts decaying
+    static constexpr double bump_growth = 1.0034717485095028;  // 2^(1/200): the counts lose half of their weight every 200 conflicts
+    int conflicts_since_restart = 0;
+    int restarts = 0;
+    static const int luby_unit = 100;  // the number of conflicts that one step of the Luby sequence stands for
+    static const int lbd_window = 50;  // the number of recent conflicts whose LBDs are compared to the average
+    vector<int> recent_lbds;  // a ring buffer of the LBDs of the conflicts since the last restart
+    size_t next_lbd = 0;  // the position in recent_lbds that is overwritten next
+    long long recent_lbd_sum = 0;
+    long long total_lbd_sum = 0;
+    long long conflicts = 0;
+    vector<CRef> learnt_clauses;
+    vector<CRef> learnt_units;  // learned clauses of length one, which are asserted on the root level and moved to level 0 by the next reset
+    bool inconsistent = false;  // whether a conflict was found that does not depend on any assumption
+    vector<int> failed;  // after an unsatisfiable call of solve(assumptions), the assumptions that the conflict depends on
+    Stats stats;
+    double progress_interval = 0;  // the number of seconds between two progress lines, 0 for none
+    chrono::steady_clock::time_point last_progress = chrono::steady_clock::now();
+    static const int max_learnt_len = 64;  // Longer learned clauses are only kept until the next clause deletion.
+    int reduce_interval = 2000;  // the number of conflicts between two clause deletions, which grows after every deletion
+    int conflicts_until_reduce = reduce_interval;
+    size_t mem_limit;  // Learned clauses are deleted early when they take more than a quarter of it.
+    size_t original_words = 0;  // the size of the formula's clauses in the arena, which are never deleted
+    uint64_t seed;  // the seed that rng starts from for every formula
+    Random rng;
+    Proof* proof = nullptr;  // receives the learned and deleted clauses, not with pure literal elimination, whose assignments are not implied
+    static const int pure_lit_depth = 3;  // Pure literals are only searched for up to this decision level.
+    static const int simd_min_len = 16;  // Shorter scans do not pay for the call of a vectorized kernel.
+    static const int lookahead_candidates = 24;  // the number of variables whose literals lookahead propagates per decision
+    vector<Variable*> candidates;  // the variables that lookahead tries
+    vector<int> implied[2];  // the literals that the positive and the negative literal of a candidate imply
+    vector<pair<Variable*, Value>> probed_phases;  // the saved phases of the variables that a probe assigned, which it restores
+    vector<int> implied_stamp;  // implied_stamp[var] is +-round if the positive literal of the candidate of that round implies var or -var
+    int round = 0;
+    void (Solver::*count_assignment)(Variable*);  // the part of set that counts without watched literals, specialized for the configuration
+    void (Solver::*count_unassignment)(Variable*);  // the same for unset
+
+    Solver(const Formula&, const Config&, const atomic<bool>* stop = nullptr);
+    Solver(const Solver&) = delete;
+    Solver& operator=(const Solver&) = delete;
+    void load(const Formula&);
+
+    Value lit_value(int);
+    uint8_t* values_by_lit() { return lit_values.data() + variables.size() - 1; }  // indexed by a literal, from -num_vars to num_vars
+    int scan_not_false(Clause& cl, int begin) { return (cl.size - begin < simd_min_len) ? scan_not_false_scalar(cl, begin) : first_not_false(cl.begin(), begin, cl.size, values_by_lit()); }
+    int scan_not_false_scalar(Clause& cl, int begin);
+    int index_of(Variable* var) { return var - &variables[0]; }
+    int true_lit(Variable*);
+    vector<CRef>& watch_list(int);
+    bool is_consistent(Variable*);
+    Value pick_polarity(Variable*);
+    void init_cl_len_counts();
+    void set(Variable*, Value, Mark, CRef = no_clause);
+    void unset(Variable*);
+    template<class Policy> void count_set(Variable*);
+    template<class Policy> void count_unset(Variable*);
+    void select_counting_code();
+    void update_watches(Variable*);
+    void unit_prop();
+    void pure_lit();
+    void decide(Variable*, Value);
+    void log_with_decisions(vector<int> lits);
+    int probe(int lit, vector<int>& implied_lits);
+    void force(int lit);
+    void lookahead();
+    void bump(Variable*);
+    void decay_backtrack_counts();
+    void record_conflict(int lbd);
+    bool restart_due();
+    void restart_search();
+    void shuffle_priorities();
+    bool backtrack();
+    void backtrack_to(int level);
+    void garbage_collect();
+    void reduce_learnt();
+    bool memory_short();
+    CRef add_learnt(const vector<int>&, int);
+    bool backjump();
+    void analyze_final(int false_lit = 0);
+    bool assume(const vector<int>& cube);
+    vector<int> split();
+    void reset();
+    void report_progress();
+    Result solve();
+    Result next_model();
+    void add_vars(int num_vars);
+    bool add_clause(const vector<int>&);
+    Result solve(const vector<int>& assumptions);
+};
+
+// The cubes that wait to be solved in the cube-and-conquer mode. A worker that runs out of work waits here until a busy worker splits its cube.
+struct CubeQueue {
+    mutex m;
+    condition_variable cv;
+    vector<vector<int>> cubes;
+    int workers;
+    int idle = 0;  // the number of workers waiting in pop
+    atomic<int> hungry{0};  // the same as idle, but readable by the search loops without taking the lock
+    atomic<bool> stop{false};  // set when a model has been found
+
+    explicit CubeQueue(int workers) : workers(workers) {}
+    bool pop(vector<int>& cube);
+    void donate(Solver&);
+};
+
+// A natural number of any size, since a formula with n variables can have up to 2^n models.
+struct BigCount {
+    vector<uint32_t> limbs;  // the digits in base 2^32, least significant first, without leading zeros
+
+    BigCount(uint64_t value = 0);
+    bool is_zero() const { return limbs.empty(); }
+    BigCount& operator+=(const BigCount&);
+    BigCount operator*(const BigCount&) const;
+    void shift(int bits);
+    string to_string() const;
+};
+
+struct ClausesHash {
+    size_t operator()(const vector<int>& flat) const;
+};
+
+// Counts the models of a formula exactly. Under a partial assignment, the remaining clauses fall apart into components that share no variable, whose counts multiply, and the count of every component is cached, so a component that the search meets again under another assignment is not counted again.
+struct ModelCounter {
+    static const size_t cache_limit = 1 << 20;  // The cache is emptied when it holds this many components.
+    int num_vars;
+    vector<vector<int>> clauses;
+    vector<Value> values;  // the assignment of propagate, all unset between calls
+    vector<int> trail;
+    vector<int> parent;  // the union-find forest of split, indexed by variable
+    vector<int> occurrences;  // the scratch counts of count_component, indexed by variable
+    vector<int> component_of;  // the scratch map of split from the root of a variable to its component + 1
+    vector<vector<int>> occ_lists;  // the scratch occurrence lists of propagate, indexed by literal + num_vars, holding clause indices
+    vector<int> open;  // the scratch counts of propagate of the literals of each clause that have not been propagated as false
+    unordered_map<vector<int>, BigCount, ClausesHash> cache;  // by the clauses of a component in canonical order, each followed by 0
+    long long components = 0;  // the components that were counted without the cache
+    long long cache_hits = 0;
+
+    // The clauses left after propagating a literal, split into components whose counts are multiplied one after the other.
+    struct SplitFrame {
+        vector<vector<vector<int>>> comps;
+        vector<int> num_comp_vars;
+        size_t next = 0;  // the next component to count
+        BigCount product;
+        int free_vars = 0;  // the variables that are neither assigned nor in a component
+    };
+    // A component that is counted by branching on best, first true and then false.
+    struct ComponentFrame {
+        vector<vector<int>> clauses;
+        vector<int> key;
+        int num_vars = 0;
+        int best = 0;
+        bool second_branch = false;
+        BigCount total;
+    };
+
+    explicit ModelCounter(Formula&);
+    bool propagate(const vector<vector<int>>& in, int lit, vector<vector<int>>& out, int& assigned);
+    vector<vector<vector<int>>> split(vector<vector<int>>& in, vector<int>& num_comp_vars);
+    SplitFrame open_split(const vector<vector<int>>& in, int lit, int num_in_vars);
+    BigCount count();
+};
 
-void backtrack();
+extern const vector<Config> portfolio_configs;
+Result solve_cubes(const Formula&, const Config&, int n, vector<Value>& model, Stats&);
+Result solve_portfolio(const Formula&, int n, uint64_t seed, vector<Value>& model, Stats&);
+void solve_batch(const vector<string>& files, const Config&, bool preprocess, int workers, ostream& out);
 
 #endif
\ No newline at end of file
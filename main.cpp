@@ -0,0 +1,250 @@
+#include "dpll_solver.h"
+
+// Print the peak resident memory of the process and, with a memory limit, how much of the clauses was placed in files.
+static void print_memory(const Config& config) {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    cout << "c peak memory: " << usage.ru_maxrss / 1024 << " MiB\n";  // ru_maxrss is in KiB
+    if (config.mem_limit > 0) {
+        cout << "c peak clause memory: " << ArenaMemory::peak / (1 << 20) << " MiB, of which " << ArenaMemory::peak_spilled / (1 << 20) << " MiB in files\n";
+    }
+}
+
+// Print a model as a v line.
+static void print_model(const vector<Value>& model) {
+    cout << "v ";
+    for (int i = 1; i < model.size(); ++i) {
+        cout << ((model[i] == Value::t) ? i : -i) << " ";
+    }
+    cout << "0\n";
+}
+
+int main(int argc, const char* argv[]) {
+    vector<string> filenames;
+    Config config;
+    int portfolio_size = 0;  // the number of solvers that run in parallel, 0 without the portfolio mode
+    int cube_workers = 0;  // the number of threads of the cube-and-conquer mode, 0 without it
+    bool preprocess = false;
+    string stats_file;  // the JSON file for the statistics, empty for none
+    double progress_interval = 0;  // the number of seconds between two progress lines, 0 for none
+    string proof_file;  // the DRAT proof of an unsatisfiable formula, empty for none
+    int batch_workers = 0;  // the number of threads that solve the files of a batch, 0 for a single file
+    bool enumerate = false;
+    long long enumerate_limit = 0;  // the number of models after which the enumeration stops, 0 for all
+    bool count_models = false;
+     
+    for (int i = 1; i < argc; ++i) {
+        string option = string(argv[i]);
+        
+        if (option[0] == '-' && option != "-") {
+            if (option == "-slis") { config.heu = Heuristic::slis; }
+            else if (option == "-slcs") { config.heu = Heuristic::slcs; }
+            else if (option == "-dlis") { config.heu = Heuristic::dlis; }
+            else if (option == "-dlcs") { config.heu = Heuristic::dlcs; }
+            else if (option == "-bc") { config.heu = Heuristic::backtrack_count; }
+            else if (option == "-mom") { config.heu = Heuristic::mom; }
+            else if (option == "-boehm") { config.heu = Heuristic::boehm; }
+            else if (option == "-jw") { config.heu = Heuristic::jw; }
+            else if (option == "-la") { config.heu = Heuristic::lookahead; }
+            else if (option == "-p") { config.use_pure_lit = true; }
+            else if (option == "-wl") { config.use_watched = true; }
+            else if (option == "-cdcl") { config.use_cdcl = true; config.use_watched = true; }
+            else if (option == "-pre") { preprocess = true; }
+            else if (option == "-luby") { config.restart = Restart::luby; }
+            else if (option == "-glucose") { config.restart = Restart::glucose; }
+            else if (option == "--portfolio" && i+1 < argc && atoi(argv[i+1]) > 0) { portfolio_size = min(atoi(argv[++i]), (int)portfolio_configs.size()); }
+            else if (option == "--cubes" && i+1 < argc && atoi(argv[i+1]) > 0) { cube_workers = atoi(argv[++i]); }
+            else if (option == "--seed" && i+1 < argc) { config.seed = strtoull(argv[++i], nullptr, 10); }
+            else if (option == "--stats" && i+1 < argc) { stats_file = argv[++i]; }
+            else if (option == "--progress" && i+1 < argc && atof(argv[i+1]) > 0) { progress_interval = atof(argv[++i]); }
+            else if (option == "--proof" && i+1 < argc) { proof_file = argv[++i]; }
+            else if (option == "--batch" && i+1 < argc && atoi(argv[i+1]) > 0) { batch_workers = atoi(argv[++i]); }
+            else if (option == "--enumerate") {
+                enumerate = true;
+                // The limit is optional, therefore only a number is taken as the limit and not as a file name.
+                if (i+1 < argc && *argv[i+1] != '\0' && strspn(argv[i+1], "0123456789") == strlen(argv[i+1])) { enumerate_limit = atoll(argv[++i]); }
+            }
+            else if (option == "--count") { count_models = true; }
+            else if (option == "--mem-limit" && i+1 < argc && atoi(argv[i+1]) > 0) { config.mem_limit = (size_t)atoi(argv[++i]) << 20; }
+            else {
+                cout << "Unknown argument: " << option << "\nPossible options:\n";
+                cout << "-slis\tuse the S(tatic)LIS heuristic\n";
+                cout << "-slcs\tuse the S(tatic)LCS heuristic\n";
+                cout << "-dlis\tuse the DLIS heuristic\n";
+                cout << "-dlcs\tuse the DLCS heuristic\n";
+                cout << "-bc\tbacktrack count: a heuristic based on how many times a variable has been backtracked\n";
+                cout << "-mom\tuse the MOM heuristic\n";
+                cout << "-boehm\tuse Boehm's heuristic\n";
+                cout << "-jw\tuse the Jeroslow-Wang heuristic\n";
+                cout << "-la\tlookahead: branch on the variable whose literals propagate the most, and force failed literals\n";
+                cout << "-p\tenable pure literal elimination\n";
+                cout << "-wl\tuse two watched literals for unit propagation (only with -slis, -slcs, -bc or no heuristic)\n";
+                cout << "-cdcl\tlearn clauses from conflicts and backjump non-chronologically (implies -wl)\n";
+                cout << "-pre\tsimplify the formula before the search\n";
+                cout << "-luby\trestart after a number of conflicts that follows the Luby sequence, with phase saving\n";
+                cout << "-glucose\trestart when the recent learned clauses have a high LBD, with phase saving (only with -cdcl)\n";
+                cout << "--portfolio N\trun N different configurations in parallel threads and take the first answer (up to " << portfolio_configs.size() << ", not combined with the other options)\n";
+                cout << "--cubes N\tsplit the search into cubes that N threads solve in parallel\n";
+                cout << "--seed S\tseed the random numbers of the default heuristic (with --portfolio and --cubes, thread i gets S+i)\n";
+                cout << "--batch N\tsolve all the given files, or the problems on stdin for \"-\", with N threads and print one line per problem\n";
+                cout << "--stats FILE\twrite the statistics to a JSON file (only in builds with -DDPLL_STATS)\n";
+                cout << "--proof FILE\twrite a binary DRAT proof if the formula is unsatisfiable (not with -p, --portfolio and --cubes)\n";
+                cout << "--enumerate [N]\tprint all models, or the first N, as they are found (only with -wl, heuristics and --seed)\n";
+                cout << "--count\tcount the models exactly, splitting the formula into independent components (not combined with the other options)\n";
+                cout << "--mem-limit MB\tkeep the learned clauses within a quarter of MB megabytes and place large clause arenas in temporary files that the kernel can page out\n";
+                cout << "--progress S\tprint a progress line every S seconds, without --portfolio and --cubes (only in builds with -DDPLL_STATS)\n";
+                exit(1);
+            }
+        } else { filenames.push_back(option); }
+    }
+    // When no file name is given.
+    if (filenames.empty()) {
+        cout << "No filename specified\n";
+        cout << "usage: dpll_solver <path to a cnf file> [-pre] [-p] [-wl] [-cdcl] [-luby | -glucose] [heuristics] [--cubes N] | [--portfolio N]\n";
+        cout << "       dpll_solver <path to a cnf file> --enumerate [N] [-wl] [heuristics] | --count\n";
+        cout << "       dpll_solver --batch N <cnf files or - for stdin> [-pre] [-p] [-wl] [-cdcl] [-luby | -glucose] [heuristics]\n";
+        exit(1);
+    }
+    if (filenames.size() > 1 && batch_workers == 0) {
+        cout << "Several files can only be solved with --batch\n";
+        exit(1);
+    }
+
+    // The portfolio chooses the configurations of its solvers itself.
+    if (portfolio_size > 0 && (config.heu != Heuristic::none || config.use_pure_lit || config.use_watched || config.restart != Restart::none || cube_workers > 0)) {
+        cout << "--portfolio cannot be combined with other options\n";
+        exit(1);
+    }
+    // Watched literals do not keep track of active clauses, which the other heuristics and pure literal elimination rely on.
+    if (config.use_watched && (config.use_pure_lit || (config.heu != Heuristic::none && config.heu != Heuristic::slis && config.heu != Heuristic::slcs && config.heu != Heuristic::backtrack_count))) {
+        cout << (config.use_cdcl ? "-cdcl" : "-wl") << " can only be combined with -slis, -slcs, -bc or no heuristic\n";
+        exit(1);
+    }
+    // The Glucose restarts compare the LBDs of learned clauses.
+    if (config.restart == Restart::glucose && !config.use_cdcl) {
+        cout << "-glucose can only be combined with -cdcl\n";
+        exit(1);
+    }
+    // A proof can only contain clauses that follow from the formula, which pure literals do not, and only one thread can write it.
+    if (!proof_file.empty() && (config.use_pure_lit || portfolio_size > 0 || cube_workers > 0)) {
+        cout << "--proof cannot be combined with -p, --portfolio or --cubes\n";
+        exit(1);
+    }
+    // A batch prints one line per problem instead of the statistics, proofs and models of a single formula.
+    if (batch_workers > 0 && (portfolio_size > 0 || cube_workers > 0 || !proof_file.empty() || !stats_file.empty() || progress_interval > 0)) {
+        cout << "--batch cannot be combined with --portfolio, --cubes, --proof, --stats or --progress\n";
+        exit(1);
+    }
+    // Pure literals, the preprocessing, learned clauses and restarts each lose models or would find some twice, and only a single thread can continue its search after a model.
+    if ((enumerate || count_models) && (config.use_pure_lit || preprocess || config.use_cdcl || config.restart != Restart::none || portfolio_size > 0 || cube_workers > 0 || batch_workers > 0 || !proof_file.empty())) {
+        cout << (enumerate ? "--enumerate" : "--count") << " cannot be combined with -p, -pre, -cdcl, -luby, -glucose, --portfolio, --cubes, --batch or --proof\n";
+        exit(1);
+    }
+    if (count_models && (enumerate || config.heu != Heuristic::none || config.use_watched)) {
+        cout << "--count cannot be combined with --enumerate, -wl or heuristics\n";
+        exit(1);
+    }
+    // A quarter of the limit for the clauses of one solver leaves room for the arena that garbage collection copies them into, the watch lists and the per-variable data.
+    if (config.mem_limit > 0) { ArenaMemory::spill_threshold = config.mem_limit / 4; }
+    if (batch_workers > 0) {
+        solve_batch(filenames, config, preprocess, batch_workers, cout);
+        print_memory(config);
+        return 0;
+    }
+    string filename = filenames[0];
+#ifndef DPLL_STATS
+    if (!stats_file.empty() || progress_interval > 0) {
+        cout << "--stats and --progress need a build with -DDPLL_STATS\n";
+        exit(1);
+    }
+#endif
+
+    unique_ptr<Proof> proof;
+    if (!proof_file.empty()) {
+        proof = make_unique<Proof>();
+        if (!proof->open(proof_file)) {
+            cout << "Cannot write " << proof_file << "\n";
+            exit(1);
+        }
+    }
+
+    Stats stats;
+    auto parse_start = chrono::steady_clock::now();
+    Formula formula;
+    bool sat_possible = fromFile(filename, formula);
+    chrono::duration<double> parse_time = chrono::steady_clock::now() - parse_start;
+    stats.parse_time = parse_time.count();
+    cout << "c parse time: " << parse_time.count() << "s\n";
+    if (sat_possible && preprocess) {
+        auto preprocess_start = chrono::steady_clock::now();
+        Preprocessor preprocessor(formula);
+        preprocessor.proof = proof.get();
+        int vars_before = preprocessor.count_vars();
+        int clauses_before = preprocessor.count_clauses();
+        sat_possible = preprocessor.run();
+        chrono::duration<double> preprocess_time = chrono::steady_clock::now() - preprocess_start;
+        stats.preprocess_time = preprocess_time.count();
+        cout << "c preprocessing: " << vars_before << " -> " << preprocessor.count_vars() << " variables, " << clauses_before << " -> " << preprocessor.count_clauses() << " clauses in " << preprocess_time.count() << "s\n";
+    }
+    if (count_models) {
+        auto count_start = chrono::steady_clock::now();
+        ModelCounter counter(formula);
+        BigCount models = counter.count();
+        chrono::duration<double> count_time = chrono::steady_clock::now() - count_start;
+        cout << "c components: " << counter.components << " counted, " << counter.cache_hits << " from the cache in " << count_time.count() << "s\n";
+        print_memory(config);
+        cout << (models.is_zero() ? "s UNSATISFIABLE\n" : "s SATISFIABLE\n");
+        cout << "c models: " << models.to_string() << "\n";
+        return 0;
+    }
+    Result result = Result::unsat;
+    vector<Value> model;
+    long long models = 0;  // the number of models that --enumerate has printed
+    if (!sat_possible) {
+        // The formula contains an empty clause or the preprocessing has derived one.
+    } else if (portfolio_size > 0) {
+        result = solve_portfolio(formula, portfolio_size, config.seed, model, stats);
+    } else if (cube_workers > 0) {
+        result = solve_cubes(formula, config, cube_workers, model, stats);
+    } else {
+        Solver solver(formula, config);
+        // The solver has copied the clauses, and the model only needs the reconstruction stack.
+        formula.clauses = ClauseArena();
+        solver.proof = proof.get();
+        solver.progress_interval = progress_interval;
+        result = solver.solve();
+        // Every model is printed as soon as it is found, and the search goes on from it.
+        for (; enumerate && result == Result::sat; result = solver.next_model()) {
+            if (models == 0) { cout << "s SATISFIABLE\n"; }
+            model.clear();
+            for (Variable& var: solver.variables) { model.push_back(var.value); }
+            print_model(model);
+            if (++models == enumerate_limit) { break; }
+        }
+        for (Variable& var: solver.variables) { model.push_back(var.value); }
+        stats += solver.stats;
+    }
+#ifdef DPLL_STATS
+    stats.print(cout);
+    if (!stats_file.empty() && !stats.write_json(stats_file)) { cout << "c cannot write " << stats_file << "\n"; }
+#endif
+    print_memory(config);
+    if (enumerate) {
+        if (models == 0) { cout << "s UNSATISFIABLE\n"; }
+        cout << "c models: " << models << ((result == Result::sat) ? " (stopped at the limit)" : "") << "\n";
+        return 0;
+    }
+    if (proof != nullptr) {
+        // The empty clause follows by unit propagation from the formula and the clauses in the proof.
+        if (result == Result::unsat) { proof->add({}); }
+        if (!proof->close()) { cout << "c cannot write " << proof_file << "\n"; }
+    }
+    if (result == Result::unsat) {
+        cout << "s UNSATISFIABLE\n";
+        return 0;
+    }
+    formula.extend_model(model);
+    cout << "s SATISFIABLE\n";
+    print_model(model);
+    return 0;
+}